@@ -0,0 +1,339 @@
+// Benchmark com dados sintéticos reproduzíveis. Gera cidades, vias e
+// profissionais a partir de uma semente, mede cada operação individualmente
+// e imprime percentis de latência. Uso:
+//   bench_saude [--cidades N] [--densidade D] [--hospitais F] [--profissionais N]
+//               [--distribuicao uniforme|agrupada] [--nomes aleatorios|ordenados]
+//               [--consultas N] [--raio R] [--k K] [--semente S] [--csv]
+#include "registro_saude.h"
+#include <random>
+
+/* ===========================
+        PARÂMETROS
+=========================== */
+struct ConfigBench {
+    int cidades = 900;
+    double densidade = 3.0;       // vias de saída por cidade (média)
+    double hospitais = 0.05;      // fração de cidades com hospital
+    int profissionais = 200000;
+    bool agrupada = false;        // profissionais em aglomerados em vez de uniformes
+    bool nomesOrdenados = false;  // inserção em ordem alfabética (pior caso da árvore)
+    int consultas = 20000;
+    int raio = 200;
+    int k = 10;
+    uint64_t semente = 42;
+    bool csv = false;
+};
+
+const int LADO_MAPA = 100000;     // coordenadas em [0, LADO_MAPA)
+
+/* ===========================
+        DADOS SINTÉTICOS
+=========================== */
+struct DadosBench {
+    vector<pair<string, bool>> cidades;
+    vector<Coord> posCidades;
+    vector<Aresta> vias;
+    struct Prof {
+        string nome;
+        IdEsp esp;
+        int crm;
+        Coord pos;
+    };
+    vector<Prof> profs;
+};
+
+string nomeAleatorio(mt19937_64 &rng) {
+    static const char *const silabas[] = {"ma", "ri", "jo", "se", "an", "to", "lu", "ca",
+                                          "pe", "dro", "fer", "nan", "da", "gu", "sil", "va"};
+    string s;
+    int n = 2 + rng() % 4;
+    for (int i = 0; i < n; i++) s += silabas[rng() % 16];
+    s[0] = (char)toupper(s[0]);
+    return s;
+}
+
+DadosBench gerarDados(const ConfigBench &cfg) {
+    DadosBench d;
+    mt19937_64 rng(cfg.semente);
+    auto uniforme = [&](double a, double b) { return uniform_real_distribution<double>(a, b)(rng); };
+
+    for (int i = 1; i <= cfg.cidades; i++)
+        d.cidades.push_back({"Cidade " + to_string(i), uniforme(0, 1) < cfg.hospitais});
+    // Coordenadas com gerador próprio: o restante dos dados não muda
+    mt19937_64 rngPos(cfg.semente + 1);
+    for (int i = 1; i <= cfg.cidades; i++)
+        d.posCidades.push_back({(int)(rngPos() % LADO_MAPA), (int)(rngPos() % LADO_MAPA)});
+
+    // Malha com cara de estrada: uma espinha de mão dupla garante ligação e
+    // as demais vias ligam cidades de IDs próximos (diâmetro grande)
+    int n = cfg.cidades;
+    for (int i = 1; i < n; i++) {
+        int w = 1 + rng() % 30;
+        d.vias.push_back({i, i + 1, w});
+        d.vias.push_back({i + 1, i, w});
+    }
+    long long extras = (long long)(cfg.densidade * n) - 2LL * (n - 1);
+    for (long long e = 0; e < extras; e++) {
+        int o = 1 + rng() % n;
+        int dd = min(n, max(1, o + (int)(rng() % 101) - 50));
+        if (dd != o) d.vias.push_back({o, dd, 1 + (int)(rng() % 60)});
+    }
+
+    // CRMs distintos em ordem embaralhada
+    vector<int> crms(cfg.profissionais);
+    for (int i = 0; i < cfg.profissionais; i++) crms[i] = 100000 + i;
+    shuffle(crms.begin(), crms.end(), rng);
+
+    vector<Coord> centros;
+    for (int i = 0; i < 32; i++)
+        centros.push_back({(int)uniforme(0, LADO_MAPA), (int)uniforme(0, LADO_MAPA)});
+    normal_distribution<double> espalho(0, LADO_MAPA / 80.0);
+
+    for (int i = 0; i < cfg.profissionais; i++) {
+        DadosBench::Prof p;
+        if (cfg.nomesOrdenados) {
+            char buf[32];
+            snprintf(buf, sizeof buf, "Profissional %08d", i);
+            p.nome = buf;
+        } else {
+            p.nome = nomeAleatorio(rng) + " " + nomeAleatorio(rng) + " " + to_string(i);
+        }
+        p.esp = (IdEsp)(rng() % QTD_ESPECIALIDADES);
+        p.crm = crms[i];
+        if (cfg.agrupada) {
+            const Coord &c = centros[rng() % centros.size()];
+            p.pos = {(int)min<double>(LADO_MAPA - 1, max(0.0, c.x + espalho(rng))),
+                     (int)min<double>(LADO_MAPA - 1, max(0.0, c.y + espalho(rng)))};
+        } else {
+            p.pos = {(int)uniforme(0, LADO_MAPA), (int)uniforme(0, LADO_MAPA)};
+        }
+        d.profs.push_back(p);
+    }
+    return d;
+}
+
+/* ===========================
+        MEDIÇÃO
+=========================== */
+struct Medicao {
+    string nome;
+    vector<double> ns;            // uma amostra por operação
+};
+
+struct Relatorio {
+    vector<Medicao> linhas;
+    bool csv = false;
+};
+
+typedef chrono::steady_clock Relogio;
+
+inline double decorrido(Relogio::time_point t0) {
+    return chrono::duration<double, nano>(Relogio::now() - t0).count();
+}
+
+// Mede f(i) para i em [0, n), uma amostra por chamada
+template <class F>
+void medir(Relatorio &rel, const string &nome, size_t n, F f) {
+    Medicao m{nome, {}};
+    m.ns.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        auto t0 = Relogio::now();
+        f(i);
+        m.ns.push_back(decorrido(t0));
+    }
+    rel.linhas.push_back(move(m));
+}
+
+void imprimirRelatorio(Relatorio &rel) {
+    auto pct = [](const vector<double> &v, double p) {
+        return v[min(v.size() - 1, (size_t)(p * (v.size() - 1) + 0.5))];
+    };
+    if (rel.csv)
+        printf("operacao,n,media_us,p50_us,p90_us,p99_us,p999_us,max_us\n");
+    else
+        printf("\n%-28s %9s %10s %10s %10s %10s %10s %10s\n", "operacao (us)", "n",
+               "media", "p50", "p90", "p99", "p99.9", "max");
+    for (Medicao &m : rel.linhas) {
+        if (m.ns.empty()) continue;
+        sort(m.ns.begin(), m.ns.end());
+        double soma = 0;
+        for (double v : m.ns) soma += v;
+        double val[] = {soma / m.ns.size(), pct(m.ns, 0.5), pct(m.ns, 0.9), pct(m.ns, 0.99),
+                        pct(m.ns, 0.999), m.ns.back()};
+        if (rel.csv) printf("%s,%zu", m.nome.c_str(), m.ns.size());
+        else printf("%-28s %9zu", m.nome.c_str(), m.ns.size());
+        for (double v : val) printf(rel.csv ? ",%.3f" : " %10.3f", v / 1000);
+        printf("\n");
+    }
+}
+
+// Descarta o que as listagens escrevem no cout enquanto são medidas
+struct SaidaNula : streambuf {
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+/* ===========================
+        CENÁRIO
+=========================== */
+void executar(const ConfigBench &cfg) {
+    auto tGera = Relogio::now();
+    DadosBench d = gerarDados(cfg);
+    fprintf(stderr, "dados: %d cidades, %zu vias, %zu profissionais (%.0f ms)\n",
+            cfg.cidades, d.vias.size(), d.profs.size(), decorrido(tGera) / 1e6);
+
+    Relatorio rel;
+    rel.csv = cfg.csv;
+    mt19937_64 rng(cfg.semente ^ 0x9E3779B97F4A7C15ull);
+    size_t q = cfg.consultas;
+
+    // Cadastros, um a um como no menu
+    medir(rel, "cidadeInserir", d.cidades.size(),
+          [&](size_t i) { cidadeInserir(d.cidades[i].first, d.cidades[i].second, d.posCidades[i]); });
+    medir(rel, "viaInserir", d.vias.size(),
+          [&](size_t i) { viaInserir(d.vias[i].o, d.vias[i].d, d.vias[i].peso); });
+    medir(rel, "profissionalInserir", d.profs.size(), [&](size_t i) {
+        const DadosBench::Prof &p = d.profs[i];
+        profissionalInserir(p.nome, p.esp, p.crm, p.pos);
+    });
+
+    // Buscas por chave: metade existente, metade ausente
+    vector<string> nomes(q);
+    vector<int> crms(q);
+    for (size_t i = 0; i < q; i++) {
+        const DadosBench::Prof &p = d.profs[rng() % d.profs.size()];
+        nomes[i] = i % 2 ? p.nome : p.nome + "#";
+        crms[i] = i % 2 ? p.crm : -(int)(rng() % 1000000) - 1;
+    }
+    size_t achados = 0;
+    medir(rel, "arvoreBuscar (nome)", q,
+          [&](size_t i) { achados += arvoreBuscar(arvoreNome, nomes[i]) != SEM_ID; });
+    medir(rel, "crmExiste", q, [&](size_t i) { achados += crmExiste(crms[i]); });
+    // Prefixo: as 5 primeiras letras; aproximado: o nome com uma letra trocada
+    medir(rel, "nomesNormalizadosConstruir", 1,
+          [&](size_t) { nomesNormalizadosConstruir(nomesNormalizados); });
+    medir(rel, "buscarPrefixo (20)", q,
+          [&](size_t i) { achados += buscarPrefixo(nomes[i].substr(0, 5), 20).size(); });
+    medir(rel, "buscarAproximado (d=2, 20)", q, [&](size_t i) {
+        string s = nomes[i];
+        s[s.size() / 2] = 'x';
+        achados += buscarAproximado(s, 2, 20).size();
+    });
+
+    // Hospital mais próximo em cada modo
+    vector<int> inicios(q);
+    for (size_t i = 0; i < q; i++) inicios[i] = 1 + rng() % qtdCidades;
+    long long somaCustos = 0;
+    auto rotas = [&](const string &nome) {
+        medir(rel, nome, q, [&](size_t i) { somaCustos += rotaHospital(inicios[i]).custo; });
+    };
+    modoHospital = MODO_DIJKSTRA;
+    rotas("rotaHospital (dijkstra)");
+    medir(rel, "tabelaConstruir", 1, [&](size_t) { tabelaConstruir(tabelaHosp); });
+    modoHospital = MODO_TABELA;
+    rotas("rotaHospital (tabela)");
+    medir(rel, "chConstruir", 1, [&](size_t) { chConstruir(indiceCH); });
+    modoHospital = MODO_CH;
+    rotas("rotaHospital (ch)");
+    modoHospital = MODO_TRECHOS;
+    rotas("rotaHospital (trechos)");
+    modoHospital = MODO_DIJKSTRA;
+    // k hospitais: primeira passada calcula, a segunda sai do cache
+    const int K_HOSPITAIS = 5;
+    medir(rel, "kHospitais (k=5)", q,
+          [&](size_t i) { somaCustos += kHospitais(inicios[i], K_HOSPITAIS, false).size(); });
+    medir(rel, "kHospitais (cache)", q,
+          [&](size_t i) { somaCustos += kHospitais(inicios[i], K_HOSPITAIS, false).size(); });
+
+    // Proximidade
+    vector<Coord> centros(q);
+    for (size_t i = 0; i < q; i++) {
+        const DadosBench::Prof &p = d.profs[rng() % d.profs.size()];
+        centros[i] = i % 2 ? p.pos : Coord{(int)(rng() % LADO_MAPA), (int)(rng() % LADO_MAPA)};
+    }
+    size_t encontrados = 0;
+    medir(rel, string("gradeRaio (") + kernelDistancia.nome + ")", q,
+          [&](size_t i) { encontrados += gradeRaio(grade, centros[i], cfg.raio).size(); });
+    // Todas as consultas de uma vez, pelo pool
+    medir(rel, "gradeRaioLote (todos)", 1, [&](size_t) {
+        for (const vector<Vizinho> &r : gradeRaioLote(grade, centros, cfg.raio)) encontrados += r.size();
+    });
+    medir(rel, "gradeKProximos", q,
+          [&](size_t i) { encontrados += gradeKProximos(grade, centros[i], cfg.k).size(); });
+    medir(rel, "espKProximos", q, [&](size_t i) {
+        encontrados += espKProximos(indiceEsp, (IdEsp)(i % QTD_ESPECIALIDADES), centros[i], cfg.k).size();
+    });
+
+    // Relatório de escala: profissionais x hospitais, pelo pool
+    medir(rel, "atribuirHospitais (todos)", 1, [&](size_t) {
+        encontrados += atribuirHospitais().size();
+    });
+    medir(rel, "profissionaisPorHospital", 1, [&](size_t) {
+        for (const EquipeHospital &e : profissionaisPorHospital(cfg.raio))
+            encontrados += e.profissionais.size();
+    });
+
+    // Listagens completas, com a formatação, descartando a saída
+    SaidaNula nula;
+    streambuf *original = cout.rdbuf(&nula);
+    medir(rel, "listarPorNome", 3, [&](size_t) { listarPorNome(arvoreNome); });
+    medir(rel, "listarPorEspecialidade", 3, [&](size_t) { listarPorEspecialidade(indiceEsp); });
+    medir(rel, "paginaPorNome (50)", q, [&](size_t i) {
+        encontrados += paginaPorNome(arvoreNome, nomes[i], 50).size();
+    });
+    cout.rdbuf(original);
+
+    // Leituras pela API de versões publicadas, uma a uma e em lote
+    RegistroSaude reg;
+    medir(rel, "registroIniciar (publicar)", 1, [&](size_t) { registroIniciar(reg); });
+    medir(rel, "registroRotaHospital", q,
+          [&](size_t i) { somaCustos += registroRotaHospital(reg, inicios[i]).custo; });
+    medir(rel, "registroKHospitais (k=5)", q,
+          [&](size_t i) { somaCustos += registroKHospitais(reg, inicios[i], K_HOSPITAIS).size(); });
+    medir(rel, "registroLoteRotas (lote)", 1,
+          [&](size_t) { somaCustos += registroLoteRotas(reg, inicios).size(); });
+    medir(rel, "registroLoteRaio (lote)", 1,
+          [&](size_t) { encontrados += registroLoteRaio(reg, centros, cfg.raio).size(); });
+    registroEncerrar(reg);
+
+    imprimirRelatorio(rel);
+    // Impede que o compilador descarte as consultas
+    fprintf(stderr, "verificacao: %zu %lld %zu\n", achados, somaCustos, encontrados);
+}
+
+void uso(const char *prog) {
+    fprintf(stderr, "Uso: %s [--cidades N] [--densidade D] [--hospitais F] [--profissionais N]"
+            " [--distribuicao uniforme|agrupada] [--nomes aleatorios|ordenados]"
+            " [--consultas N] [--raio R] [--k K] [--semente S] [--csv]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    ConfigBench cfg;
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        bool temValor = i + 1 < argc;
+        if (a == "--csv") cfg.csv = true;
+        else if (!temValor) { uso(argv[0]); return 1; }
+        else if (a == "--cidades") cfg.cidades = atoi(argv[++i]);
+        else if (a == "--densidade") cfg.densidade = atof(argv[++i]);
+        else if (a == "--hospitais") cfg.hospitais = atof(argv[++i]);
+        else if (a == "--profissionais") cfg.profissionais = atoi(argv[++i]);
+        else if (a == "--distribuicao") cfg.agrupada = string(argv[++i]) == "agrupada";
+        else if (a == "--nomes") cfg.nomesOrdenados = string(argv[++i]) == "ordenados";
+        else if (a == "--consultas") cfg.consultas = atoi(argv[++i]);
+        else if (a == "--raio") cfg.raio = atoi(argv[++i]);
+        else if (a == "--k") cfg.k = atoi(argv[++i]);
+        else if (a == "--semente") cfg.semente = strtoull(argv[++i], NULL, 10);
+        else { uso(argv[0]); return 1; }
+    }
+    if (cfg.cidades < 2 || cfg.cidades > MAX_CIDADES) {
+        fprintf(stderr, "--cidades deve estar entre 2 e %d\n", MAX_CIDADES);
+        return 1;
+    }
+    if (cfg.profissionais < 1 || cfg.consultas < 1) {
+        uso(argv[0]);
+        return 1;
+    }
+    executar(cfg);
+    return 0;
+}
@@ -1,149 +1,135 @@
-#include <iostream>
-#include <cmath>
-#include <string>
-
-#define INF 1000
-using namespace std;
+// Interface de menu do sistema. Estruturas e algoritmos ficam em nucleo.h;
+// para embutir o cadastro em outro programa, veja registro_saude.h; o modo
+// servidor (--server/--socket) está em servidor.h.
+#include "nucleo.h"
+#include "servidor.h"
 
 /* ===========================
-   ESTRUTURAS DE CIDADES
+        MENUS AUXILIARES
 =========================== */
-int qtdCidades = 0;
-int numeroCidade[INF];
-bool hospital[INF];
-string nomeCidade[INF];
-int grafo[INF][INF];
-
-/* ===========================
-   ESTRUTURAS DE PROFISSIONAIS
-=========================== */
-struct Coord {
-    int x, y;
-};
-
-struct Profissional {
-    string nome;
-    string especialidade;
-    int crm;
-    Coord pos;
-};
-
-struct DataType {
-    string key;
-    Profissional prof;
-};
-
-/* ===========================
-   ÁRVORES BINÁRIAS
-=========================== */
-struct Node {
-    DataType data;
-    Node *left, *right;
-};
+IdEsp escolherEspecialidade() {
+    int op;
+    cout << "\n=== ESPECIALIDADES ===\n";
+    for (int i = 0; i < QTD_ESPECIALIDADES; i++)
+        cout << i + 1 << ". " << ESPECIALIDADES[i] << '\n';
 
-Node *raizNome = NULL;
-Node *raizEsp = NULL;
+    do {
+        cout << "Escolha: ";
+        cin >> op;
+        cin.ignore();
+    } while (op < 1 || op > QTD_ESPECIALIDADES);
 
-/* ===========================
-   FUNÇÕES DE ÁRVORE
-=========================== */
-void insert(Node *&curr, DataType data) {
-    if (!curr) {
-        curr = new Node{data, NULL, NULL};
-    } else if (data.key >= curr->data.key) {
-        insert(curr->right, data);
-    } else {
-        insert(curr->left, data);
-    }
+    return (IdEsp)(op - 1);
 }
 
-Node* search(Node* curr, string key) {
-    if (!curr) return NULL;
-    if (key == curr->data.key) return curr;
-    if (key > curr->data.key) return search(curr->right, key);
-    return search(curr->left, key);
+void listarUmaEspecialidade() {
+    IdEsp esp = escolherEspecialidade();
+    cout << "\n--- " << ESPECIALIDADES[esp] << " ---\n";
+    listarEspecialidade(indiceEsp, esp);
+    cout << "Total: " << espContar(indiceEsp, esp) << " profissionais.\n";
 }
 
-bool crmExiste(Node* curr, int crm) {
-    if (!curr) return false;
-    if (curr->data.prof.crm == crm) return true;
-    return crmExiste(curr->left, crm) || crmExiste(curr->right, crm);
+int lerTamanhoPagina() {
+    int n;
+    cout << "Itens por pagina: ";
+    cin >> n;
+    cin.ignore();
+    return max(n, 1);
 }
 
-void listarPorNome(Node* curr) {
-    if (!curr) return;
-    listarPorNome(curr->left);
-    cout << "| Nome: " << curr->data.prof.nome << endl;
-    cout << "| Especialidade: " << curr->data.prof.especialidade << endl;
-    cout << "| CRM: " << curr->data.prof.crm << endl;
-    cout << "| Coordenadas: (" << curr->data.prof.pos.x << ", "
-         << curr->data.prof.pos.y << ")\n\n";
-    listarPorNome(curr->right);
-}
+void paginarPorNome() {
+    string apos;
+    cout << "Comecar apos o nome (vazio = inicio): ";
+    getline(cin, apos);
+    int n = lerTamanhoPagina();
 
-void listarPorEspecialidade(Node* curr) {
-    if (!curr) return;
-    listarPorEspecialidade(curr->left);
-    cout << "| Especialidade: " << curr->data.prof.especialidade << endl;
-    cout << "| Nome: " << curr->data.prof.nome << endl;
-    cout << "| CRM: " << curr->data.prof.crm << endl;
-    cout << "| Coordenadas: (" << curr->data.prof.pos.x << ", "
-         << curr->data.prof.pos.y << ")\n\n";
-    listarPorEspecialidade(curr->right);
+    vector<IdProf> pagina = paginaPorNome(arvoreNome, apos, n);
+    {
+        SaidaBuffer out;
+        for (IdProf id : pagina) imprimirProfissional(out, id);
+    }
+    if (pagina.size() == (size_t)n)
+        cout << "Proxima pagina: apos \"" << prof(pagina.back()).nome << "\"\n";
+    else
+        cout << "Fim da lista.\n";
 }
 
-// Liberação de memória (Pós-ordem)
-void liberarArvore(Node* curr) {
-    if (!curr) return;
-    liberarArvore(curr->left);
-    liberarArvore(curr->right);
-    delete curr;
+// Nome incompleto ou com erro de digitação; sem diferenciar maiúsculas e acentos
+void buscarNomeParcial() {
+    string texto;
+    int tipo;
+    cout << "Nome ou inicio do nome: ";
+    getline(cin, texto);
+    cout << "1. Comeca com o texto\n2. Aproximado (ate 2 letras diferentes)\nEscolha: ";
+    cin >> tipo;
+    int n = lerTamanhoPagina();
+
+    SaidaBuffer out;
+    if (tipo == 2) {
+        vector<NomeAproximado> res = buscarAproximado(texto, 2, n);
+        for (const NomeAproximado &r : res) {
+            out << "[" << r.distancia << "] ";
+            imprimirProfissional(out, r.id);
+        }
+        if (res.empty()) out << "Nenhum nome parecido.\n";
+    } else {
+        vector<IdProf> res = buscarPrefixo(texto, n);
+        for (IdProf id : res) imprimirProfissional(out, id);
+        if (res.empty()) out << "Nenhum nome comeca com esse texto.\n";
+    }
 }
 
-/* ===========================
-        ESPECIALIDADES
-=========================== */
-void escolherEspecialidade(string &esp) {
-    int op;
-    string lista[8] = {
-        "Clinico Geral", "Cardiologia", "Pediatria", "Ortopedia",
-        "Neurologia", "Dermatologia", "Psiquiatria", "Ginecologia"
-    };
-
-    cout << "\n=== ESPECIALIDADES ===\n";
-    for (int i = 0; i < 8; i++)
-        cout << i + 1 << ". " << lista[i] << endl;
-
-    do {
-        cout << "Escolha: ";
-        cin >> op;
-        cin.ignore();
-    } while (op < 1 || op > 8);
-
-    esp = lista[op - 1];
+void paginarEspecialidade() {
+    IdEsp esp = escolherEspecialidade();
+    long long apos;
+    cout << "Cursor (-1 = inicio): ";
+    cin >> apos;
+    int n = lerTamanhoPagina();
+
+    IdProf cursor = (apos < 0 || apos >= SEM_ID) ? SEM_ID : (IdProf)apos;
+    vector<IdProf> pagina = paginaEspecialidade(indiceEsp, esp, cursor, n);
+    {
+        SaidaBuffer out;
+        for (IdProf id : pagina) imprimirPorEspecialidade(out, id);
+    }
+    if (pagina.size() == (size_t)n)
+        cout << "Proxima pagina: cursor " << pagina.back() << "\n";
+    else
+        cout << "Fim da lista.\n";
 }
 
 /* ===========================
-        CADASTROS
+        CADASTROS (MENU)
 =========================== */
 void cadastrarCidade() {
-    if (qtdCidades >= INF - 1) {
+    string nome;
+    cout << "Nome da cidade/bairro: ";
+    getline(cin, nome);
+    if (!cidadeCabe(nome)) {
         cout << "Limite de cidades atingido.\n";
         return;
     }
-    qtdCidades++;
-    numeroCidade[qtdCidades] = qtdCidades;
-
-    cout << "Nome da cidade/bairro: ";
-    getline(cin, nomeCidade[qtdCidades]);
 
     cout << "Possui hospital? (1-Sim 2-Nao): ";
-    int op;
+    int op, temPos;
     cin >> op;
+    cout << "Informar coordenadas? (1-Sim 2-Nao): ";
+    cin >> temPos;
+    Coord pos = SEM_POSICAO;
+    if (temPos == 1) {
+        cout << "Coordenada X: ";
+        cin >> pos.x;
+        cout << "Coordenada Y: ";
+        cin >> pos.y;
+    }
     cin.ignore();
-    hospital[qtdCidades] = (op == 1);
 
-    cout << "Cidade " << nomeCidade[qtdCidades] << " cadastrada com ID: " << qtdCidades << endl;
+    if (!logCidade(nome, op == 1, pos)) {
+        cout << "Erro: falha ao gravar o log; cidade nao cadastrada.\n";
+        return;
+    }
+    int id = cidadeInserir(nome, op == 1, pos);
+    cout << "Cidade " << cidadeNome(id) << " cadastrada com ID: " << id << '\n';
 }
 
 void cadastrarEstrada() {
@@ -159,130 +145,424 @@ void cadastrarEstrada() {
         return;
     }
 
-    grafo[o][d] = 1; // Orientado (mão única). Para mão dupla, adicione grafo[d][o] = 1;
-    cout << "Via cadastrada entre " << nomeCidade[o] << " e " << nomeCidade[d] << "!\n";
+    int t;
+    cout << "Tempo de percurso (min): ";
+    cin >> t;
+    cin.ignore();
+    if (t < 1) {
+        cout << "Erro: o tempo deve ser positivo.\n";
+        return;
+    }
+
+    if (!logVia(o, d, t)) {
+        cout << "Erro: falha ao gravar o log; via nao cadastrada.\n";
+        return;
+    }
+    viaInserir(o, d, t);
+    cout << "Via cadastrada entre " << cidadeNome(o) << " e " << cidadeNome(d) << "!\n";
 }
 
 void cadastrarProfissional() {
-    Profissional p;
-    DataType dNome, dEsp;
+    string nome;
+    int crm;
+    Coord pos;
 
     cout << "Nome do profissional: ";
-    getline(cin, p.nome);
-    while (search(raizNome, p.nome)) {
+    getline(cin, nome);
+    while (arvoreBuscar(arvoreNome, nome) != SEM_ID) {
         cout << "Nome ja existe. Digite outro: ";
-        getline(cin, p.nome);
+        getline(cin, nome);
     }
 
-    escolherEspecialidade(p.especialidade);
+    IdEsp esp = escolherEspecialidade();
 
     cout << "CRM: ";
-    cin >> p.crm;
-    while (crmExiste(raizNome, p.crm)) {
+    cin >> crm;
+    while (crmExiste(crm)) {
         cout << "CRM ja cadastrado. Digite outro: ";
-        cin >> p.crm;
+        cin >> crm;
     }
 
     cout << "Coordenada X: ";
-    cin >> p.pos.x;
+    cin >> pos.x;
     cout << "Coordenada Y: ";
-    cin >> p.pos.y;
+    cin >> pos.y;
     cin.ignore();
 
-    dNome.key = p.nome;
-    dNome.prof = p;
-    insert(raizNome, dNome);
-
-    dEsp.key = p.especialidade;
-    dEsp.prof = p;
-    insert(raizEsp, dEsp);
+    if (!logProfissional(nome, esp, crm, pos)) {
+        cout << "Erro: falha ao gravar o log; profissional nao cadastrado.\n";
+        return;
+    }
+    profissionalInserir(nome, esp, crm, pos);
 
     cout << "Profissional cadastrado com sucesso!\n";
 }
 
-/* ===========================
-   BUSCA DE HOSPITAL (BFS)
-=========================== */
-void buscarHospital() {
-    int inicio;
-    cout << "ID da cidade onde voce esta: ";
-    cin >> inicio;
-    cin.ignore();
+// Lê a cidade de origem por ID ou nome; -1 se não existir
+int lerCidadeOrigem() {
+    string entrada;
+    cout << "ID ou nome da cidade onde voce esta: ";
+    getline(cin, entrada);
 
-    if (inicio < 1 || inicio > qtdCidades) {
+    int inicio;
+    if (!lerInt(entrada, inicio)) {
+        garantirMaterializado(); // o hash de nomes só existe em memória
+        inicio = cidadeBuscar(entrada);
+    }
+    if (inicio < 1 || inicio > totalCidades()) {
         cout << "Cidade invalida.\n";
+        return -1;
+    }
+    return inicio;
+}
+
+void buscarHospital() {
+    int inicio = lerCidadeOrigem();
+    if (inicio == -1) return;
+
+    RotaHospital r = rotaHospital(inicio);
+    if (r.hospital == -1) {
+        cout << "Nenhum hospital acessivel a partir desta localidade.\n";
         return;
     }
+    cout << "\n>>> HOSPITAL ENCONTRADO! <<<\n";
+    cout << "Cidade: " << nomeCidadeDe(r.hospital) << " (ID: " << r.hospital << ")\n";
+    if (modoHospital == MODO_TRECHOS)
+        cout << "Trechos: " << r.custo << "\n";
+    else
+        cout << "Tempo estimado: " << r.custo << " min\n";
+    cout << "Rota: ";
+    for (size_t i = 0; i < r.caminho.size(); i++)
+        cout << (i ? " -> " : "") << nomeCidadeDe(r.caminho[i]);
+    cout << "\n";
+}
 
-    bool visitado[INF] = {false};
-    int fila[INF], frente = 0, tras = 0;
+// Alternativas para desviar quando o hospital mais próximo está lotado
+void buscarKHospitais() {
+    int inicio = lerCidadeOrigem();
+    if (inicio == -1) return;
+    int k, criterio;
+    cout << "Quantos hospitais (k): ";
+    cin >> k;
+    cout << "Criterio (1 = tempo, 2 = trechos): ";
+    cin >> criterio;
+    cin.ignore();
+    if (k < 1) {
+        cout << "k deve ser positivo.\n";
+        return;
+    }
 
-    fila[tras++] = inicio;
-    visitado[inicio] = true;
+    bool trechos = criterio == 2;
+    vector<RotaHospital> rotas = kHospitais(inicio, k, trechos);
+    if (rotas.empty()) {
+        cout << "Nenhum hospital acessivel a partir desta localidade.\n";
+        return;
+    }
+    SaidaBuffer out;
+    out << "\n=== " << rotas.size() << " HOSPITAIS MAIS PROXIMOS ===\n";
+    for (size_t i = 0; i < rotas.size(); i++) {
+        const RotaHospital &r = rotas[i];
+        out << i + 1 << ". " << nomeCidadeDe(r.hospital) << " (ID: " << r.hospital << ") - "
+            << r.custo << (trechos ? " trechos" : " min") << "\n   Rota: ";
+        for (size_t j = 0; j < r.caminho.size(); j++)
+            out << (j ? " -> " : "") << nomeCidadeDe(r.caminho[j]);
+        out << '\n';
+    }
+    if ((int)rotas.size() < k) out << "Nao ha outros hospitais acessiveis.\n";
+}
 
-    while (frente < tras) {
-        int atual = fila[frente++];
-        if (hospital[atual]) {
-            cout << "\n>>> HOSPITAL ENCONTRADO! <<<\n";
-            cout << "Cidade: " << nomeCidade[atual] << " (ID: " << atual << ")\n";
-            return;
+// Relatório de escala: cruza profissionais e hospitais pelas coordenadas
+void relatorioEscala() {
+    int tipo;
+    cout << "1. Hospital mais proximo de cada profissional\n";
+    cout << "2. Profissionais a ate R de cada hospital\nEscolha: ";
+    cin >> tipo;
+    SaidaBuffer out;
+    if (tipo == 2) {
+        int raio;
+        cout << "Raio: ";
+        cin >> raio;
+        cin.ignore();
+        for (const EquipeHospital &e : profissionaisPorHospital(max(raio, 0))) {
+            out << "\n>>> " << cidadeNome(e.hospital) << " (ID: " << e.hospital << "): "
+                << e.profissionais.size() << " profissionais\n";
+            for (const Vizinho &v : e.profissionais)
+                out << "   " << prof(v.second).nome << " - " << ESPECIALIDADES[prof(v.second).especialidade]
+                    << " - distancia " << sqrt((double)v.first) << '\n';
         }
-        for (int i = 1; i <= qtdCidades; i++) {
-            if (grafo[atual][i] != -1 && !visitado[i]) {
-                visitado[i] = true;
-                fila[tras++] = i;
-            }
+        return;
+    }
+    cin.ignore();
+    vector<HospitalMaisProximo> a = atribuirHospitais();
+    size_t sem = 0;
+    for (IdProf id = 0; id < a.size(); id++) {
+        if (a[id].hospital == -1) {
+            sem++;
+            continue;
         }
+        out << prof(id).nome << " -> " << cidadeNome(a[id].hospital) << " (ID: " << a[id].hospital
+            << ", distancia " << sqrt((double)a[id].dist2) << ")\n";
+    }
+    if (sem) out << sem << " profissionais sem hospital com coordenadas.\n";
+}
+
+// Componentes fortes que não chegam a nenhum hospital
+void listarRegioesSemHospital() {
+    const size_t MAX_NOMES = 10;
+    vector<vector<int>> regioes = regioesSemHospital();
+    size_t cidadesSem = 0;
+    SaidaBuffer out;
+    out << "\n=== REGIOES SEM ACESSO A HOSPITAL ===\n";
+    for (size_t i = 0; i < regioes.size(); i++) {
+        const vector<int> &r = regioes[i];
+        cidadesSem += r.size();
+        out << "Regiao " << i + 1 << " (" << r.size() << " cidades): ";
+        for (size_t j = 0; j < r.size() && j < MAX_NOMES; j++)
+            out << (j ? ", " : "") << cidadeNome(r[j]);
+        if (r.size() > MAX_NOMES) out << " e mais " << r.size() - MAX_NOMES;
+        out << '\n';
+    }
+    out << "Total: " << regioes.size() << " regioes, " << cidadesSem << " de " << qtdCidades
+        << " cidades sem acesso.\n";
+}
+
+void escolherModoHospital() {
+    int op;
+    cout << "\n=== MODO DE BUSCA DE HOSPITAL ===\n";
+    cout << "1. Dijkstra por consulta\n";
+    cout << "2. Tabela pre-calculada (atualizada a cada cadastro)\n";
+    cout << "3. Hierarquia de contracao (mapas estaticos; escolha de novo apos cadastros)\n";
+    cout << "4. Menor numero de trechos (BFS)\n";
+    cout << "Escolha: ";
+    cin >> op;
+    cin.ignore();
+
+    switch (op) {
+        case 2:
+            modoHospitalDefinir(MODO_TABELA);
+            cout << "Tabela de hospitais pre-calculada ativada.\n";
+            break;
+        case 3:
+            modoHospitalDefinir(MODO_CH);
+            cout << "Indice CH construido: " << indiceCH.sobe.size() + indiceCH.desce.size()
+                 << " arestas.\n";
+            break;
+        case 4:
+            modoHospitalDefinir(MODO_TRECHOS);
+            cout << "Busca por menor numero de trechos ativada.\n";
+            break;
+        default:
+            modoHospitalDefinir(MODO_DIJKSTRA);
+            cout << "Modo Dijkstra por consulta ativado.\n";
     }
-    cout << "Nenhum hospital acessivel a partir desta localidade.\n";
 }
 
 /* ===========================
    PROFISSIONAIS PRÓXIMOS
 =========================== */
-double dist(Coord a, Coord b) {
-    return sqrt(pow(a.x - b.x, 2) + pow(a.y - b.y, 2));
+void listarVizinhos(const vector<Vizinho> &res) {
+    SaidaBuffer out;
+    for (const Vizinho &v : res) {
+        out << "- " << nomeProfDe(v.second)
+            << " [" << ESPECIALIDADES[espDe(v.second)]
+            << "] Distancia: " << sqrt((double)v.first) << " unidades\n";
+    }
+    out << "Total: " << res.size() << " profissionais encontrados.\n";
 }
 
-void buscarProximos(Node* curr, Coord c, int &cont) {
-    if (!curr) return;
-    buscarProximos(curr->left, c, cont);
+void buscarProximos() {
+    Coord c;
+    int raio;
+    cout << "Sua coordenada X: "; cin >> c.x;
+    cout << "Sua coordenada Y: "; cin >> c.y;
+    cout << "Raio de busca: "; cin >> raio;
+    cin.ignore();
+    if (raio < 0) {
+        cout << "Raio invalido.\n";
+        return;
+    }
+    cout << "\nBuscando profissionais em um raio de " << raio << " unidades...\n";
+    listarVizinhos(snap.ativo ? gradeRaio(snap.grade, c, raio) : gradeRaio(grade, c, raio));
+}
 
-    double d = dist(curr->data.prof.pos, c);
-    if (d <= 100) {
-        cont++;
-        cout << "- " << curr->data.prof.nome 
-             << " [" << curr->data.prof.especialidade 
-             << "] Distancia: " << d << " unidades\n";
+void buscarPorCRM() {
+    int crm;
+    cout << "CRM: ";
+    cin >> crm;
+    cin.ignore();
+
+    IdProf id = crmBuscar(indiceCRM, crm);
+    if (id == SEM_ID) {
+        cout << "Nenhum profissional com este CRM.\n";
+        return;
     }
+    const Profissional &p = prof(id);
+    SaidaBuffer out;
+    out << "| Nome: " << p.nome << '\n'
+        << "| Especialidade: " << ESPECIALIDADES[p.especialidade] << '\n'
+        << "| CRM: " << p.crm << '\n'
+        << "| Coordenadas: (" << p.pos.x << ", " << p.pos.y << ")\n";
+}
 
-    buscarProximos(curr->right, c, cont);
+void buscarKProximos() {
+    Coord c;
+    int k;
+    cout << "Sua coordenada X: "; cin >> c.x;
+    cout << "Sua coordenada Y: "; cin >> c.y;
+    cout << "Quantidade de profissionais (k): "; cin >> k;
+    cin.ignore();
+    if (k < 1) {
+        cout << "Quantidade invalida.\n";
+        return;
+    }
+    cout << "\nOs " << k << " profissionais mais proximos:\n";
+    listarVizinhos(snap.ativo ? gradeKProximos(snap.grade, c, k) : gradeKProximos(grade, c, k));
+}
+
+void buscarKProximosEspecialidade() {
+    IdEsp esp = escolherEspecialidade();
+    Coord c;
+    int k;
+    cout << "Sua coordenada X: "; cin >> c.x;
+    cout << "Sua coordenada Y: "; cin >> c.y;
+    cout << "Quantidade de profissionais (k): "; cin >> k;
+    cin.ignore();
+    if (k < 1) {
+        cout << "Quantidade invalida.\n";
+        return;
+    }
+    cout << "\nOs " << k << " profissionais de " << ESPECIALIDADES[esp] << " mais proximos:\n";
+    listarVizinhos(kProximosEspecialidade(esp, c, k));
 }
 
 /* ===========================
             MENU
 =========================== */
+void salvarSnapshot() {
+    string caminho;
+    cout << "Arquivo do snapshot: ";
+    getline(cin, caminho);
+    if (snapshotSalvar(caminho.c_str()))
+        cout << "Snapshot gravado em " << caminho << ".\n";
+    else
+        cout << "Erro ao gravar o snapshot.\n";
+}
+
+void mostrarEstatisticas() {
+    cout << "\n=== ESTATISTICAS ===\n";
+    SaidaBuffer out;
+    metricasImprimir(out);
+}
+
+void exportarEstatisticas() {
+    string caminho;
+    cout << "Arquivo JSON (vazio = tela): ";
+    getline(cin, caminho);
+    string json = metricasJSON();
+    if (caminho.empty()) {
+        cout << json;
+        return;
+    }
+    FILE *f = fopen(caminho.c_str(), "w");
+    if (!f || fwrite(json.data(), 1, json.size(), f) != json.size()) {
+        if (f) fclose(f);
+        cout << "Erro ao gravar " << caminho << ".\n";
+        return;
+    }
+    fclose(f);
+    cout << "Estatisticas gravadas em " << caminho << ".\n";
+}
+
 void menu() {
     cout << "\n==============================\n";
     cout << "      SISTEMA DE SAUDE       \n";
     cout << "==============================\n";
     cout << "1. Cadastrar cidade\n";
     cout << "2. Cadastrar via (estrada)\n";
-    cout << "3. Buscar hospital mais proximo (Grafo)\n";
+    cout << "3. Buscar hospital mais proximo (rota)\n";
     cout << "4. Cadastrar profissional\n";
-    cout << "5. Listar profissionais por nome (BST)\n";
-    cout << "6. Listar por especialidade (BST)\n";
+    cout << "5. Listar profissionais por nome (Arvore B+)\n";
+    cout << "6. Listar por especialidade\n";
     cout << "7. Buscar profissionais proximos (Coord)\n";
+    cout << "8. Modo de busca de hospital (Dijkstra / tabela / CH / trechos)\n";
+    cout << "9. Buscar os k profissionais mais proximos\n";
+    cout << "10. Buscar profissional por CRM\n";
+    cout << "11. Listar uma especialidade\n";
+    cout << "12. Salvar snapshot\n";
+    cout << "13. Paginar profissionais por nome\n";
+    cout << "14. Paginar uma especialidade\n";
+    cout << "15. Estatisticas (latencia, contadores, memoria)\n";
+    cout << "16. Exportar estatisticas (JSON)\n";
+    cout << "17. Buscar os k mais proximos de uma especialidade\n";
+    cout << "18. Regioes sem acesso a hospital\n";
+    cout << "19. Buscar os k hospitais mais proximos (alternativas)\n";
+    cout << "20. Buscar profissional por parte do nome / nome aproximado\n";
+    cout << "21. Relatorio de escala (profissionais x hospitais)\n";
     cout << "0. Sair\n";
     cout << "Escolha uma opcao: ";
 }
 
-int main() {
-    // Inicializa a matriz do grafo com -1 (sem conexões)
-    for(int i = 0; i < INF; i++) {
-        for(int j = 0; j < INF; j++) {
-            grafo[i][j] = -1;
+void uso(const char *prog) {
+    cerr << "Uso: " << prog << " [--snapshot base.snap]"
+         << " [--import cidades.csv vias.csv profissionais.csv]"
+         << " [--wal cadastros.wal [--fsync sempre|grupo|nunca]]"
+         << " [--save-snapshot saida.snap] [--server | --socket caminho]\n";
+}
+
+int main(int argc, char *argv[]) {
+    // Argumentos aplicados na ordem: snapshot de partida e importação em lote;
+    // depois o WAL é reaplicado e, se pedido, um novo snapshot é gravado sem
+    // abrir o menu
+    const char *salvarEm = NULL, *arquivoLog = NULL, *arquivoSocket = NULL;
+    bool servidor = false;
+    ModoFsync modoFsync = FSYNC_GRUPO;
+    // No modo --server o stdout é só do protocolo; avisos da carga vão ao stderr
+    for (int i = 1; i < argc; i++)
+        if (strcmp(argv[i], "--server") == 0) cout.rdbuf(cerr.rdbuf());
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            if (!snapshotAbrir(argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--import") == 0 && i + 3 < argc) {
+            garantirMaterializado();
+            importarLote(argv[i + 1], argv[i + 2], argv[i + 3]);
+            i += 3;
+        } else if (strcmp(argv[i], "--save-snapshot") == 0 && i + 1 < argc) {
+            salvarEm = argv[++i];
+        } else if (strcmp(argv[i], "--wal") == 0 && i + 1 < argc) {
+            arquivoLog = argv[++i];
+        } else if (strcmp(argv[i], "--server") == 0) {
+            servidor = true;
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            arquivoSocket = argv[++i];
+        } else if (strcmp(argv[i], "--fsync") == 0 && i + 1 < argc) {
+            string m = argv[++i];
+            if (m == "sempre") modoFsync = FSYNC_SEMPRE;
+            else if (m == "grupo") modoFsync = FSYNC_GRUPO;
+            else if (m == "nunca") modoFsync = FSYNC_NUNCA;
+            else {
+                uso(argv[0]);
+                return 1;
+            }
+        } else {
+            uso(argv[0]);
+            return 1;
+        }
+    }
+    if (arquivoLog && !logAbrir(arquivoLog, modoFsync)) return 1;
+    if (salvarEm) {
+        bool ok = snapshotSalvar(salvarEm);
+        logFechar();
+        if (!ok) {
+            cerr << "Erro ao gravar o snapshot em " << salvarEm << "\n";
+            return 1;
         }
+        cout << "Snapshot gravado em " << salvarEm << ".\n";
+        return 0;
+    }
+    if (servidor || arquivoSocket) {
+        bool ok = arquivoSocket ? servidorSocket(arquivoSocket) : servidorStdin();
+        logFechar();
+        return ok ? 0 : 1;
     }
 
     int op;
@@ -296,6 +576,11 @@ int main() {
         }
         cin.ignore();
 
+        // Só as buscas de hospital (Dijkstra) e de proximidade leem direto do
+        // snapshot mapeado; as demais operações precisam dele em memória
+        if (op != 3 && op != 7 && op != 9 && op != 15 && op != 16 && op != 17 && op != 19 && op != 0)
+            garantirMaterializado();
+
         switch (op) {
             case 1: cadastrarCidade(); break;
             case 2: cadastrarEstrada(); break;
@@ -303,27 +588,34 @@ int main() {
             case 4: cadastrarProfissional(); break;
             case 5: 
                 cout << "\n--- LISTA POR NOME ---\n";
-                listarPorNome(raizNome); 
+                listarPorNome(arvoreNome);
                 break;
             case 6: 
                 cout << "\n--- LISTA POR ESPECIALIDADE ---\n";
-                listarPorEspecialidade(raizEsp); 
+                listarPorEspecialidade(indiceEsp);
                 break;
-            case 7: {
-                Coord c;
-                cout << "Sua coordenada X: "; cin >> c.x;
-                cout << "Sua coordenada Y: "; cin >> c.y;
-                cin.ignore();
-                int cont = 0;
-                cout << "\nBuscando profissionais em um raio de 100 unidades...\n";
-                buscarProximos(raizNome, c, cont);
-                cout << "Total: " << cont << " profissionais encontrados.\n";
-                break;
-            }
+            case 7: buscarProximos(); break;
+            case 8: escolherModoHospital(); break;
+            case 9: buscarKProximos(); break;
+            case 10: buscarPorCRM(); break;
+            case 11: listarUmaEspecialidade(); break;
+            case 12: salvarSnapshot(); break;
+            case 13: paginarPorNome(); break;
+            case 14: paginarEspecialidade(); break;
+            case 15: mostrarEstatisticas(); break;
+            case 16: exportarEstatisticas(); break;
+            case 17: buscarKProximosEspecialidade(); break;
+            case 18: listarRegioesSemHospital(); break;
+            case 19: buscarKHospitais(); break;
+            case 20: buscarNomeParcial(); break;
+            case 21: relatorioEscala(); break;
             case 0:
                 cout << "Encerrando e liberando memoria...\n";
-                liberarArvore(raizNome);
-                liberarArvore(raizEsp);
+                logFechar();
+                arvoreLiberar(arvoreNome);
+                indiceEsp = IndiceEspecialidade();
+                cadastroLiberar(cadastro);
+                if (snap.ativo) munmap((void*)snap.base, snap.tamanho);
                 break;
             default:
                 cout << "Opcao inexistente.\n";
@@ -0,0 +1,4318 @@
+// Núcleo do sistema de saúde: cidades, malha viária, profissionais, índices,
+// WAL e snapshot. Só cabeçalho; o estado de escrita é único por processo.
+#pragma once
+
+#include <iostream>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string_view>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86 1
+#endif
+
+using namespace std;
+
+/* ===========================
+        MÉTRICAS
+=========================== */
+// Histogramas log-lineares (estilo HDR): 16 sub-baldes por potência de 2,
+// erro relativo de até ~6%. Cada thread escreve só nos próprios contadores,
+// com load + store relaxados (sem instrução travada), e o relatório soma
+// todas as threads. Séries em ns são latências; as demais contam itens
+// visitados por consulta.
+enum SerieMetrica {
+    MET_CADASTRO_CIDADE, MET_CADASTRO_VIA, MET_CADASTRO_PROF,
+    MET_ROTA_HOSPITAL, MET_ROTA_NOS,
+    MET_BUSCA_NOME, MET_BUSCA_NOME_NOS, MET_BUSCA_CRM, MET_BUSCA_CRM_SONDAS,
+    MET_BUSCA_PREFIXO, MET_BUSCA_APROXIMADA,
+    MET_RAIO, MET_KPROXIMOS, MET_KPROXIMOS_ESP, MET_PROXIMIDADE_PONTOS,
+    MET_LISTAR_NOME, MET_LISTAR_ESP, MET_PAGINA,
+    MET_SAIDA,
+    MET_K_HOSPITAIS, MET_JUNCAO,
+    MET_WAL_ANEXAR, MET_IMPORTACAO, MET_SNAPSHOT_SALVAR, MET_SNAPSHOT_ABRIR, MET_PUBLICAR,
+    MET_REQUISICAO, MET_LOTE_REQUISICOES,
+    QTD_SERIES
+};
+
+struct InfoSerie {
+    const char *nome, *unidade;
+};
+
+const InfoSerie SERIES[QTD_SERIES] = {
+    {"cadastro_cidade", "ns"}, {"cadastro_via", "ns"}, {"cadastro_profissional", "ns"},
+    {"rota_hospital", "ns"}, {"rota_hospital.nos", "nos"},
+    {"busca_nome", "ns"}, {"busca_nome.nos", "nos"}, {"busca_crm", "ns"}, {"busca_crm.sondas", "sondas"},
+    {"busca_prefixo", "ns"}, {"busca_aproximada", "ns"},
+    {"raio", "ns"}, {"k_proximos", "ns"}, {"k_proximos_especialidade", "ns"},
+    {"proximidade.pontos", "pontos"},
+    {"listar_nome", "ns"}, {"listar_especialidade", "ns"}, {"pagina", "ns"},
+    {"saida", "ns"},
+    {"k_hospitais", "ns"}, {"juncao_hospitais", "ns"},
+    {"wal_anexar", "ns"}, {"importacao", "ns"}, {"snapshot_salvar", "ns"}, {"snapshot_abrir", "ns"},
+    {"publicar", "ns"},
+    {"servidor_requisicao", "ns"}, {"servidor_lote", "requisicoes"},
+};
+
+const int SUB_BALDES = 16;
+const int BALDES_HIST = SUB_BALDES * 38;   // até ~2^41 (ns: ~36 min)
+
+inline int baldeDe(uint64_t v) {
+    if (v < (uint64_t)SUB_BALDES) return (int)v;
+    int e = 63 - __builtin_clzll(v);              // e >= 4
+    int i = (e - 3) * SUB_BALDES + (int)((v >> (e - 4)) & (SUB_BALDES - 1));
+    return min(i, BALDES_HIST - 1);
+}
+
+// Maior valor que cai no balde
+inline uint64_t limiteBalde(int i) {
+    if (i < SUB_BALDES) return i;
+    int e = i / SUB_BALDES + 3;
+    uint64_t base = (uint64_t)(SUB_BALDES + i % SUB_BALDES) << (e - 4);
+    return base + ((uint64_t)1 << (e - 4)) - 1;
+}
+
+struct MetricasThread {
+    atomic<uint64_t> baldes[QTD_SERIES][BALDES_HIST];
+    atomic<uint64_t> soma[QTD_SERIES], maximo[QTD_SERIES];
+};
+
+// Threads vivas e o acumulado das que já terminaram
+struct RegistroMetricas {
+    mutex m;
+    vector<MetricasThread*> vivas;
+    MetricasThread encerradas{};
+};
+
+inline RegistroMetricas metricas;
+
+struct MetricasDaThread {
+    MetricasThread *dados = NULL;
+    ~MetricasDaThread();
+};
+
+inline thread_local MetricasDaThread metricasDaThread;
+
+inline MetricasThread& metricasLocais() {
+    MetricasDaThread &t = metricasDaThread;
+    if (!t.dados) {
+        t.dados = new MetricasThread();
+        lock_guard<mutex> trava(metricas.m);
+        metricas.vivas.push_back(t.dados);
+    }
+    return *t.dados;
+}
+
+// Incremento só do dono: dispensa fetch_add
+inline void somarLocal(atomic<uint64_t> &a, uint64_t v) {
+    a.store(a.load(memory_order_relaxed) + v, memory_order_relaxed);
+}
+
+inline void metricaRegistrar(SerieMetrica s, uint64_t v) {
+    MetricasThread &m = metricasLocais();
+    somarLocal(m.baldes[s][baldeDe(v)], 1);
+    somarLocal(m.soma[s], v);
+    if (v > m.maximo[s].load(memory_order_relaxed)) m.maximo[s].store(v, memory_order_relaxed);
+}
+
+inline void metricasSomar(MetricasThread &dest, const MetricasThread &orig) {
+    for (int s = 0; s < QTD_SERIES; s++) {
+        for (int b = 0; b < BALDES_HIST; b++)
+            somarLocal(dest.baldes[s][b], orig.baldes[s][b].load(memory_order_relaxed));
+        somarLocal(dest.soma[s], orig.soma[s].load(memory_order_relaxed));
+        uint64_t mx = orig.maximo[s].load(memory_order_relaxed);
+        if (mx > dest.maximo[s].load(memory_order_relaxed))
+            dest.maximo[s].store(mx, memory_order_relaxed);
+    }
+}
+
+inline MetricasDaThread::~MetricasDaThread() {
+    if (!dados) return;
+    lock_guard<mutex> trava(metricas.m);
+    metricasSomar(metricas.encerradas, *dados);
+    metricas.vivas.erase(find(metricas.vivas.begin(), metricas.vivas.end(), dados));
+    delete dados;
+}
+
+inline uint64_t relogioNs() {
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Mede o escopo em que foi criado
+struct Cronometro {
+    SerieMetrica serie;
+    uint64_t inicio;
+
+    explicit Cronometro(SerieMetrica s) : serie(s), inicio(relogioNs()) {}
+    ~Cronometro() { metricaRegistrar(serie, relogioNs() - inicio); }
+};
+
+// Ponto no plano, o mesmo para profissionais e cidades
+struct Coord {
+    int x, y;
+};
+
+/* ===========================
+   ESTRUTURAS DE CIDADES
+=========================== */
+// IDs de 1 a qtdCidades (0 não é usado). Tudo cresce com o número real de
+// cidades: os nomes ficam concatenados num único pool, no mesmo layout da
+// seção do snapshot (nome de v em texto[inicio[v] .. inicio[v+1])), a marca
+// de hospital é um bit por cidade e um hash dá o ID a partir do nome.
+// Deslocamentos do pool são de 32 bits, como no arquivo. Cada cidade tem
+// também uma coordenada, opcional (SEM_POSICAO) para cadastros antigos.
+const int MAX_CIDADES = INT_MAX - 2; // vetores por cidade têm n + 2 posições
+
+struct BitsetCidades {
+    vector<uint64_t> palavras;
+
+    bool operator[](int v) const { return (palavras[v >> 6] >> (v & 63)) & 1; }
+};
+
+inline void bitsetDefinir(BitsetCidades &b, int v, bool valor) {
+    if ((size_t)(v >> 6) >= b.palavras.size()) b.palavras.resize((v >> 6) + 1, 0);
+    uint64_t bit = 1ull << (v & 63);
+    if (valor) b.palavras[v >> 6] |= bit;
+    else b.palavras[v >> 6] &= ~bit;
+}
+
+// Hash nome -> ID: endereçamento aberto (sondagem linear), capacidade
+// potência de 2 e fator de carga de no máximo 1/2. Nomes repetidos apontam
+// para a primeira cidade cadastrada com eles.
+const Coord SEM_POSICAO = {INT_MIN, INT_MIN};
+
+struct CadastroCidades {
+    string texto;
+    vector<uint32_t> inicio{0, 0};   // tamanho qtdCidades + 2
+    vector<int> porNome;             // 0 = posição livre
+    vector<Coord> pos{SEM_POSICAO};  // tamanho qtdCidades + 1
+};
+
+inline int qtdCidades = 0;
+inline BitsetCidades hospital;
+inline CadastroCidades cidades;
+
+inline string_view cidadeNome(int id) {
+    return string_view(cidades.texto.data() + cidades.inicio[id],
+                       cidades.inicio[id + 1] - cidades.inicio[id]);
+}
+
+inline bool temPosicao(Coord c) {
+    return c.x != SEM_POSICAO.x || c.y != SEM_POSICAO.y;
+}
+
+inline size_t cidadePosicao(size_t capacidade, string_view nome) {
+    uint64_t h = 14695981039346656037ull; // FNV-1a
+    for (unsigned char ch : nome) h = (h ^ ch) * 1099511628211ull;
+    return (size_t)(h ^ (h >> 32)) & (capacidade - 1);
+}
+
+inline void cidadeColocar(CadastroCidades &c, int id) {
+    string_view nome = cidadeNome(id);
+    size_t i = cidadePosicao(c.porNome.size(), nome);
+    for (; c.porNome[i] != 0; i = (i + 1) & (c.porNome.size() - 1))
+        if (cidadeNome(c.porNome[i]) == nome) return;
+    c.porNome[i] = id;
+}
+
+// Indexa a cidade id (recém-incluída no pool), dobrando a tabela se preciso
+inline void cidadeIndexar(CadastroCidades &c, int id) {
+    if (2 * (size_t)id > c.porNome.size()) {
+        size_t capacidade = max<size_t>(16, c.porNome.size());
+        while (2 * (size_t)id > capacidade) capacidade *= 2;
+        c.porNome.assign(capacidade, 0);
+        for (int v = 1; v < id; v++) cidadeColocar(c, v);
+    }
+    cidadeColocar(c, id);
+}
+
+// ID da cidade com este nome, ou -1
+inline int cidadeBuscar(string_view nome) {
+    if (cidades.porNome.empty()) return -1;
+    size_t cap = cidades.porNome.size();
+    for (size_t i = cidadePosicao(cap, nome); cidades.porNome[i] != 0; i = (i + 1) & (cap - 1))
+        if (cidadeNome(cidades.porNome[i]) == nome) return cidades.porNome[i];
+    return -1;
+}
+
+// Se ainda cabe uma cidade com este nome
+inline bool cidadeCabe(string_view nome) {
+    return qtdCidades < MAX_CIDADES && cidades.texto.size() + nome.size() <= UINT32_MAX;
+}
+
+/* ===========================
+   GRAFO ESPARSO (CSR + BUFFER)
+=========================== */
+// Arestas consolidadas ficam em formato CSR: as vias que saem de v estão em
+// destino[inicio[v] .. inicio[v+1]), com o tempo de percurso em peso[].
+// Vias novas entram num buffer encadeado por vértice e são incorporadas ao
+// CSR quando o buffer cresce demais.
+//
+// Cada via vale até INT_MAX minutos, então custos de caminhos (e atalhos da
+// CH) somam em 64 bits: nem INT_MAX vias de INT_MAX minutos transbordam.
+typedef int64_t Custo;
+const Custo DIST_INF = numeric_limits<Custo>::max();
+
+struct Aresta {
+    int o, d, peso;
+};
+
+struct Grafo {
+    int n = 0;                    // maior ID de vértice (IDs 1..n, 0 não usado)
+    vector<int> inicio{0, 0};     // tamanho n + 2
+    vector<int> destino, peso;
+    vector<int> cabeca{-1};       // primeira via pendente de cada vértice
+    vector<int> bufDestino, bufPeso, bufProx;
+};
+
+inline Grafo grafo;
+inline Grafo grafoReverso; // mesmas vias com o sentido invertido
+
+inline void grafoAdicionarVertice(Grafo &g) {
+    g.n++;
+    g.inicio.push_back(g.inicio.back());
+    g.cabeca.push_back(-1);
+}
+
+// Chama f(vizinho, peso) para cada via que sai de v
+template <class F>
+void paraCadaVizinho(const Grafo &g, int v, F f) {
+    for (int e = g.inicio[v]; e < g.inicio[v + 1]; e++)
+        f(g.destino[e], g.peso[e]);
+    for (int e = g.cabeca[v]; e != -1; e = g.bufProx[e])
+        f(g.bufDestino[e], g.bufPeso[e]);
+}
+
+// Retorna o endereço do peso da via o -> d, ou NULL se ela não existe
+inline int* grafoBuscarAresta(Grafo &g, int o, int d) {
+    auto ini = g.destino.begin() + g.inicio[o];
+    auto fim = g.destino.begin() + g.inicio[o + 1];
+    auto it = lower_bound(ini, fim, d);
+    if (it != fim && *it == d) return &g.peso[it - g.destino.begin()];
+    for (int e = g.cabeca[o]; e != -1; e = g.bufProx[e])
+        if (g.bufDestino[e] == d) return &g.bufPeso[e];
+    return NULL;
+}
+
+// Monta o CSR a partir de uma lista de arestas (ordenação por contagem).
+// Cada linha fica ordenada por destino; vias repetidas mantêm o menor peso.
+inline void grafoConstruir(Grafo &g, int n, const vector<Aresta> &arestas) {
+    vector<int> inicio(n + 2, 0);
+    for (const auto &a : arestas) inicio[a.o + 1]++;
+    for (int v = 0; v <= n; v++) inicio[v + 1] += inicio[v];
+
+    vector<pair<int, int>> linha(arestas.size()); // (destino, peso)
+    vector<int> pos(inicio.begin(), inicio.end() - 1);
+    for (const auto &a : arestas) linha[pos[a.o]++] = {a.d, a.peso};
+
+    vector<int> destino, peso;
+    destino.reserve(arestas.size());
+    peso.reserve(arestas.size());
+    for (int v = 0; v <= n; v++) {
+        int ini = inicio[v], fim = inicio[v + 1];
+        sort(linha.begin() + ini, linha.begin() + fim);
+        inicio[v] = (int)destino.size();
+        for (int e = ini; e < fim; e++) {
+            if (e > ini && linha[e].first == linha[e - 1].first) continue;
+            destino.push_back(linha[e].first);
+            peso.push_back(linha[e].second);
+        }
+    }
+    inicio[n + 1] = (int)destino.size();
+
+    g.n = n;
+    g.inicio.swap(inicio);
+    g.destino.swap(destino);
+    g.peso.swap(peso);
+    g.cabeca.assign(n + 1, -1);
+    g.bufDestino.clear();
+    g.bufPeso.clear();
+    g.bufProx.clear();
+}
+
+// Incorpora o buffer de vias pendentes ao CSR: O(V + E)
+inline void grafoCompactar(Grafo &g) {
+    if (g.bufDestino.empty()) return;
+    vector<Aresta> arestas;
+    arestas.reserve(g.destino.size() + g.bufDestino.size());
+    for (int v = 1; v <= g.n; v++)
+        paraCadaVizinho(g, v, [&](int d, int w) { arestas.push_back({v, d, w}); });
+    grafoConstruir(g, g.n, arestas);
+}
+
+// Retorna false se já existia uma via o -> d com peso menor ou igual
+inline bool grafoAdicionarAresta(Grafo &g, int o, int d, int w) {
+    int *existente = grafoBuscarAresta(g, o, d);
+    if (existente) {
+        if (*existente <= w) return false;
+        *existente = w;
+        return true;
+    }
+    g.bufDestino.push_back(d);
+    g.bufPeso.push_back(w);
+    g.bufProx.push_back(g.cabeca[o]);
+    g.cabeca[o] = (int)g.bufDestino.size() - 1;
+
+    // Compacta quando o buffer passa de 1/4 do CSR (custo amortizado O(1))
+    if (g.bufDestino.size() >= max<size_t>(256, g.destino.size() / 4))
+        grafoCompactar(g);
+    return true;
+}
+
+/* ===========================
+   ROTAS ATÉ HOSPITAIS
+=========================== */
+struct RotaHospital {
+    int hospital = -1;      // -1 = nenhum hospital acessível
+    Custo custo = 0;        // tempo total de percurso
+    vector<int> caminho;    // cidades da origem até o hospital
+};
+
+typedef priority_queue<pair<Custo, int>, vector<pair<Custo, int>>,
+                       greater<pair<Custo, int>>> HeapMin;
+
+/* ===========================
+   TABELA DE HOSPITAL MAIS PRÓXIMO
+=========================== */
+// Dijkstra de múltiplas origens a partir de todos os hospitais sobre o grafo
+// reverso: dist[v] é o menor tempo de v até um hospital e proxSalto[v] é a
+// próxima cidade da rota. Novas vias e novos hospitais só propagam as
+// distâncias que melhoraram.
+struct TabelaHospital {
+    bool ativa = false;
+    vector<Custo> dist;      // DIST_INF = nenhum hospital acessível
+    vector<int> maisProximo; // ID do hospital mais próximo
+    vector<int> proxSalto;   // próxima cidade no caminho até ele
+};
+
+inline TabelaHospital tabelaHosp;
+
+// Relaxa a partir dos vértices do heap, cujas distâncias acabaram de melhorar
+inline void tabelaPropagar(TabelaHospital &t, HeapMin &heap) {
+    while (!heap.empty()) {
+        auto [d, atual] = heap.top();
+        heap.pop();
+        if (d != t.dist[atual]) continue;
+        paraCadaVizinho(grafoReverso, atual, [&](int ant, int w) {
+            if (d + w < t.dist[ant]) {
+                t.dist[ant] = d + w;
+                t.maisProximo[ant] = t.maisProximo[atual];
+                t.proxSalto[ant] = atual;
+                heap.push({d + w, ant});
+            }
+        });
+    }
+}
+
+inline void tabelaConstruir(TabelaHospital &t) {
+    t.dist.assign(qtdCidades + 1, DIST_INF);
+    t.maisProximo.assign(qtdCidades + 1, -1);
+    t.proxSalto.assign(qtdCidades + 1, -1);
+    HeapMin heap;
+    for (int v = 1; v <= qtdCidades; v++) {
+        if (hospital[v]) {
+            t.dist[v] = 0;
+            t.maisProximo[v] = v;
+            heap.push({0, v});
+        }
+    }
+    tabelaPropagar(t, heap);
+    t.ativa = true;
+}
+
+inline void tabelaNovaCidade(TabelaHospital &t, int id) {
+    if (!t.ativa) return;
+    t.dist.push_back(DIST_INF);
+    t.maisProximo.push_back(-1);
+    t.proxSalto.push_back(-1);
+    if (hospital[id]) {
+        t.dist[id] = 0;
+        t.maisProximo[id] = id;
+        HeapMin heap;
+        heap.push({0, id});
+        tabelaPropagar(t, heap);
+    }
+}
+
+inline void tabelaNovaVia(TabelaHospital &t, int o, int d, int w) {
+    if (!t.ativa || t.dist[d] == DIST_INF) return;
+    if (t.dist[d] + w >= t.dist[o]) return;
+    t.dist[o] = t.dist[d] + w;
+    t.maisProximo[o] = t.maisProximo[d];
+    t.proxSalto[o] = d;
+    HeapMin heap;
+    heap.push({t.dist[o], o});
+    tabelaPropagar(t, heap);
+}
+
+inline RotaHospital rotaTabela(const TabelaHospital &t, int inicio) {
+    RotaHospital r;
+    if (t.dist[inicio] == DIST_INF) return r;
+    r.hospital = t.maisProximo[inicio];
+    r.custo = t.dist[inicio];
+    for (int v = inicio; v != -1; v = t.proxSalto[v])
+        r.caminho.push_back(v);
+    metricaRegistrar(MET_ROTA_NOS, r.caminho.size());
+    return r;
+}
+
+/* ===========================
+   HIERARQUIA DE CONTRAÇÃO (CH)
+=========================== */
+// Pré-processamento para mapas estáticos: os vértices são contraídos um a um
+// (ordem por diferença de arestas) e atalhos preservam os menores caminhos.
+// Todo menor caminho passa a ter a forma "sobe e depois desce" no ranking, então:
+//   - desce[v] = menor custo descendo de v até algum hospital, calculado numa
+//     varredura em ordem crescente de ranking (refeita quando surge hospital);
+//   - a consulta é um Dijkstra só pelas arestas que sobem a partir da origem,
+//     minimizando distSubida(v) + desce[v].
+// Vértices com mais de GRAU_MAX_CH vizinhos ativos não são contraídos: quando
+// só restam vértices assim, eles formam o núcleo, no topo do ranking. Os
+// atalhos já preservam as distâncias entre eles, e as arestas do núcleo
+// entram nas duas listas (sobem e descem), então a consulta e o cálculo de
+// desce[] viram um Dijkstra comum dentro do núcleo. Isso limita a construção
+// em grafos densos, onde contrair um vértice de grau alto custaria
+// entrada x saída buscas testemunha e outros tantos atalhos.
+const int GRAU_MAX_CH = 16;
+const int PRIORIDADE_NUCLEO = INT_MAX;
+// Vértices assentados por busca testemunha ao contrair (a simulação que
+// calcula a prioridade usa 1/5 disto)
+const int LIMITE_TESTEMUNHA_CH = 100;
+
+struct ArestaCH {
+    int para;
+    Custo peso;
+    int meio; // vértice contraído que originou o atalho (-1 = via original)
+};
+
+struct IndiceCH {
+    bool pronto = false;
+    vector<int> ranking;
+    vector<int> ordem;                      // vértices por ranking crescente
+    int inicioNucleo = 0;                   // ordem[inicioNucleo..] = núcleo
+    vector<int> iniSobe, iniDesce;          // CSR por vértice
+    vector<ArestaCH> sobe, desce;
+    vector<Custo> distDesce;                // desce[v] descrito acima
+    vector<int> arestaDesce;                // aresta usada na descida (-1 = hospital)
+};
+
+inline IndiceCH indiceCH;
+
+// Menor custo de u até alvo sem passar por 'evitar', limitado a 'limite'.
+// A busca testemunha é interrompida após poucos vértices, ou quando os
+// 'alvos' vértices marcados em alvo[] foram assentados: na dúvida, o atalho
+// é criado (nunca compromete a corretude, só o tamanho do índice).
+struct BuscaTestemunha {
+    vector<Custo> dist;
+    vector<int> tocados;
+    vector<pair<Custo, int>> heap;
+    vector<uint8_t> alvo;                   // vizinhos de saída do contraído
+};
+
+// Grafo de trabalho da construção (listas de adjacência que ganham os
+// atalhos) e vetores auxiliares reaproveitados entre as contrações
+struct TrabalhoCH {
+    vector<vector<ArestaCH>> saida, entrada;
+    vector<bool> contraido;
+    vector<int> vizContraidos;
+    vector<int> posicao;                    // -1 fora de chRelaxarArestas
+    vector<ArestaCH> novasSaida;
+    vector<vector<ArestaCH>> novasEntrada;  // por aresta de saída do contraído
+    BuscaTestemunha b;
+};
+
+inline void testemunhaDijkstra(BuscaTestemunha &b, const vector<vector<ArestaCH>> &saida,
+                               const vector<bool> &contraido, int u, int evitar, Custo limite,
+                               int alvos, int maxAssentados) {
+    for (int v : b.tocados) b.dist[v] = DIST_INF;
+    b.tocados.clear();
+
+    vector<pair<Custo, int>> &heap = b.heap;
+    auto maior = greater<pair<Custo, int>>();
+    heap.clear();
+    b.dist[u] = 0;
+    b.tocados.push_back(u);
+    heap.push_back({0, u});
+    int assentados = 0;
+    while (!heap.empty() && assentados < maxAssentados && alvos > 0) {
+        pop_heap(heap.begin(), heap.end(), maior);
+        auto [d, v] = heap.back();
+        heap.pop_back();
+        if (d != b.dist[v]) continue;
+        if (d > limite) break;
+        assentados++;
+        alvos -= b.alvo[v];
+        for (const ArestaCH &a : saida[v]) {
+            if (a.para == evitar || contraido[a.para]) continue;
+            if (d + a.peso < b.dist[a.para]) {
+                if (b.dist[a.para] == DIST_INF) b.tocados.push_back(a.para);
+                b.dist[a.para] = d + a.peso;
+                heap.push_back({d + a.peso, a.para});
+                push_heap(heap.begin(), heap.end(), maior);
+            }
+        }
+    }
+}
+
+// Insere ou melhora as arestas 'novas' numa lista de adjacência de trabalho.
+// posicao[] marca onde cada vizinho já está na lista: O(lista + novas), sem
+// varrer a lista a cada aresta.
+inline void chRelaxarArestas(vector<ArestaCH> &lista, const vector<ArestaCH> &novas,
+                             vector<int> &posicao) {
+    if (novas.empty()) return;
+    for (size_t i = 0; i < lista.size(); i++) posicao[lista[i].para] = (int)i;
+    for (const ArestaCH &a : novas) {
+        int &p = posicao[a.para];
+        if (p == -1) {
+            p = (int)lista.size();
+            lista.push_back(a);
+        } else if (a.peso < lista[p].peso) {
+            lista[p] = a;
+        }
+    }
+    for (const ArestaCH &a : lista) posicao[a.para] = -1;
+}
+
+// Simula (ou executa) a contração de v; retorna quantos atalhos seriam criados
+inline int chContrair(TrabalhoCH &t, int v, bool aplicar) {
+    vector<ArestaCH> &saidaV = t.saida[v];
+    if (aplicar) {
+        t.novasEntrada.resize(max(t.novasEntrada.size(), saidaV.size()));
+        for (size_t j = 0; j < saidaV.size(); j++) t.novasEntrada[j].clear();
+    }
+    int atalhos = 0, alvos = 0;
+    for (const ArestaCH &out : saidaV)
+        if (!t.contraido[out.para]) {
+            t.b.alvo[out.para] = 1;
+            alvos++;
+        }
+    for (const ArestaCH &in : t.entrada[v]) {
+        int u = in.para;
+        if (t.contraido[u]) continue;
+        Custo limite = 0;
+        for (const ArestaCH &out : saidaV)
+            if (!t.contraido[out.para] && out.para != u)
+                limite = max(limite, in.peso + out.peso);
+        if (limite == 0) continue;
+        testemunhaDijkstra(t.b, t.saida, t.contraido, u, v, limite, alvos,
+                           aplicar ? LIMITE_TESTEMUNHA_CH : LIMITE_TESTEMUNHA_CH / 5);
+        t.novasSaida.clear();
+        for (size_t j = 0; j < saidaV.size(); j++) {
+            int x = saidaV[j].para;
+            if (t.contraido[x] || x == u) continue;
+            Custo viaV = in.peso + saidaV[j].peso;
+            if (t.b.dist[x] <= viaV) continue;
+            atalhos++;
+            if (aplicar) {
+                t.novasSaida.push_back({x, viaV, v});
+                t.novasEntrada[j].push_back({u, viaV, v});
+            }
+        }
+        if (aplicar) chRelaxarArestas(t.saida[u], t.novasSaida, t.posicao);
+    }
+    for (const ArestaCH &out : saidaV) t.b.alvo[out.para] = 0;
+    if (aplicar)
+        for (size_t j = 0; j < saidaV.size(); j++)
+            chRelaxarArestas(t.entrada[saidaV[j].para], t.novasEntrada[j], t.posicao);
+    return atalhos;
+}
+
+inline int chPrioridade(TrabalhoCH &t, int v) {
+    int grau = 0;
+    for (const ArestaCH &a : t.saida[v]) grau += !t.contraido[a.para];
+    for (const ArestaCH &a : t.entrada[v]) grau += !t.contraido[a.para];
+    if (grau > GRAU_MAX_CH) return PRIORIDADE_NUCLEO;
+    return chContrair(t, v, false) - grau + t.vizContraidos[v];
+}
+
+// Recalcula desce[] para o conjunto atual de hospitais: O(V + E) fora do
+// núcleo, mais um Dijkstra pelas arestas do núcleo no sentido inverso
+inline void chCalcularDescida(IndiceCH &ch) {
+    int n = qtdCidades;
+    ch.distDesce.assign(n + 1, DIST_INF);
+    ch.arestaDesce.assign(n + 1, -1);
+    auto descer = [&](int v) {
+        if (hospital[v]) {
+            ch.distDesce[v] = 0;
+            return;
+        }
+        for (int e = ch.iniDesce[v]; e < ch.iniDesce[v + 1]; e++) {
+            const ArestaCH &a = ch.desce[e];
+            if (ch.distDesce[a.para] == DIST_INF) continue;
+            if (a.peso + ch.distDesce[a.para] < ch.distDesce[v]) {
+                ch.distDesce[v] = a.peso + ch.distDesce[a.para];
+                ch.arestaDesce[v] = e;
+            }
+        }
+    };
+    for (int i = 0; i < ch.inicioNucleo; i++) descer(ch.ordem[i]);
+    if (ch.inicioNucleo == (int)ch.ordem.size()) return;
+
+    // No núcleo, as arestas de desce[] entre vértices dele não respeitam o
+    // ranking. As que saem para fora do núcleo já têm o destino calculado;
+    // o resto se propaga pelas arestas do núcleo, de trás para a frente.
+    unordered_map<int, vector<pair<int, int>>> chegam; // x -> (v, aresta v -> x)
+    HeapMin heap;
+    for (size_t i = ch.inicioNucleo; i < ch.ordem.size(); i++) {
+        int v = ch.ordem[i];
+        for (int e = ch.iniDesce[v]; e < ch.iniDesce[v + 1]; e++)
+            if (ch.ranking[ch.desce[e].para] > ch.inicioNucleo)
+                chegam[ch.desce[e].para].push_back({v, e});
+        descer(v);
+        if (ch.distDesce[v] != DIST_INF) heap.push({ch.distDesce[v], v});
+    }
+    while (!heap.empty()) {
+        auto [d, x] = heap.top();
+        heap.pop();
+        if (d != ch.distDesce[x]) continue;
+        auto it = chegam.find(x);
+        if (it == chegam.end()) continue;
+        for (auto [v, e] : it->second) {
+            if (d + ch.desce[e].peso < ch.distDesce[v]) {
+                ch.distDesce[v] = d + ch.desce[e].peso;
+                ch.arestaDesce[v] = e;
+                heap.push({ch.distDesce[v], v});
+            }
+        }
+    }
+}
+
+inline void chConstruir(IndiceCH &ch) {
+    int n = qtdCidades;
+    TrabalhoCH t;
+    t.saida.resize(n + 1);
+    t.entrada.resize(n + 1);
+    for (int v = 1; v <= n; v++) {
+        paraCadaVizinho(grafo, v, [&](int d, int w) {
+            if (d == v) return;
+            t.saida[v].push_back({d, w, -1});
+            t.entrada[d].push_back({v, w, -1});
+        });
+    }
+
+    t.contraido.assign(n + 1, false);
+    t.vizContraidos.assign(n + 1, 0);
+    t.posicao.assign(n + 1, -1);
+    t.b.dist.assign(n + 1, DIST_INF);
+    t.b.alvo.assign(n + 1, 0);
+
+    HeapMin fila;
+    for (int v = 1; v <= n; v++) fila.push({chPrioridade(t, v), v});
+
+    // Listas finais: ao contrair v, suas arestas para vértices ainda ativos
+    // sobem a partir de v (saída) ou descem até v (entrada)
+    vector<vector<ArestaCH>> sobe(n + 1), desce(n + 1);
+    ch.ranking.assign(n + 1, 0);
+    ch.ordem.clear();
+    int proximoRanking = 0;
+    while (!fila.empty()) {
+        int v = fila.top().second;
+        fila.pop();
+        if (t.contraido[v]) continue;
+        // Atualização preguiçosa: reavalia e reinsere se piorou
+        Custo atual = chPrioridade(t, v);
+        if (!fila.empty() && atual > fila.top().first) {
+            fila.push({atual, v});
+            continue;
+        }
+        // Só restam vértices de grau alto: o resto é o núcleo
+        if (atual == PRIORIDADE_NUCLEO) break;
+
+        chContrair(t, v, true);
+        for (const ArestaCH &a : t.saida[v]) {
+            if (t.contraido[a.para]) continue;
+            sobe[v].push_back(a);
+            t.vizContraidos[a.para]++;
+        }
+        for (const ArestaCH &a : t.entrada[v]) {
+            if (t.contraido[a.para]) continue;
+            desce[a.para].push_back({v, a.peso, a.meio});
+            t.vizContraidos[a.para]++;
+        }
+        t.contraido[v] = true;
+        ch.ranking[v] = ++proximoRanking;
+        ch.ordem.push_back(v);
+        // Tira v das listas dos vizinhos, que senão crescem a cada contração
+        // em volta de um vértice de grau alto
+        auto semContraidos = [&](vector<ArestaCH> &lista) {
+            lista.erase(remove_if(lista.begin(), lista.end(),
+                                  [&](const ArestaCH &a) { return t.contraido[a.para]; }),
+                        lista.end());
+        };
+        for (const ArestaCH &a : t.saida[v]) semContraidos(t.entrada[a.para]);
+        for (const ArestaCH &a : t.entrada[v]) semContraidos(t.saida[a.para]);
+        t.saida[v].clear();
+        t.saida[v].shrink_to_fit();
+        t.entrada[v].clear();
+        t.entrada[v].shrink_to_fit();
+    }
+
+    // Núcleo: as arestas entre os vértices dele sobem e descem
+    ch.inicioNucleo = (int)ch.ordem.size();
+    for (int v = 1; v <= n; v++) {
+        if (t.contraido[v]) continue;
+        for (const ArestaCH &a : t.saida[v]) {
+            if (t.contraido[a.para]) continue;
+            sobe[v].push_back(a);
+            desce[v].push_back(a);
+        }
+        ch.ranking[v] = ++proximoRanking;
+        ch.ordem.push_back(v);
+    }
+
+    auto achatar = [n](vector<vector<ArestaCH>> &listas, vector<int> &ini,
+                       vector<ArestaCH> &arestas) {
+        ini.assign(n + 2, 0);
+        arestas.clear();
+        for (int v = 0; v <= n; v++) {
+            ini[v] = (int)arestas.size();
+            arestas.insert(arestas.end(), listas[v].begin(), listas[v].end());
+        }
+        ini[n + 1] = (int)arestas.size();
+    };
+    achatar(sobe, ch.iniSobe, ch.sobe);
+    achatar(desce, ch.iniDesce, ch.desce);
+
+    chCalcularDescida(ch);
+    ch.pronto = true;
+}
+
+// Peso e vértice intermediário da aresta a -> b no índice
+inline const ArestaCH* chAresta(const IndiceCH &ch, int a, int b) {
+    bool subindo = ch.ranking[b] > ch.ranking[a];
+    const vector<int> &ini = subindo ? ch.iniSobe : ch.iniDesce;
+    const vector<ArestaCH> &arestas = subindo ? ch.sobe : ch.desce;
+    for (int e = ini[a]; e < ini[a + 1]; e++)
+        if (arestas[e].para == b) return &arestas[e];
+    return NULL;
+}
+
+// Expande o atalho a -> b em vias originais, acrescentando ao caminho (sem 'a')
+inline void chDesempacotar(const IndiceCH &ch, int a, int b, vector<int> &caminho) {
+    vector<pair<int, int>> pilha{{a, b}};
+    while (!pilha.empty()) {
+        auto [u, v] = pilha.back();
+        pilha.pop_back();
+        const ArestaCH *e = chAresta(ch, u, v);
+        if (e->meio == -1) {
+            caminho.push_back(v);
+        } else {
+            pilha.push_back({e->meio, v});
+            pilha.push_back({u, e->meio});
+        }
+    }
+}
+
+inline RotaHospital rotaCH(const IndiceCH &ch, int inicio) {
+    RotaHospital r;
+    unordered_map<int, pair<Custo, int>> dist; // vértice -> (distância, predecessor)
+    HeapMin heap;
+    dist[inicio] = {0, -1};
+    heap.push({0, inicio});
+
+    Custo melhor = DIST_INF;
+    int topo = -1;
+    uint64_t assentados = 0;
+    while (!heap.empty()) {
+        auto [d, v] = heap.top();
+        heap.pop();
+        if (d >= melhor) break;
+        if (d != dist[v].first) continue;
+        assentados++;
+        if (ch.distDesce[v] != DIST_INF && d + ch.distDesce[v] < melhor) {
+            melhor = d + ch.distDesce[v];
+            topo = v;
+        }
+        for (int e = ch.iniSobe[v]; e < ch.iniSobe[v + 1]; e++) {
+            const ArestaCH &a = ch.sobe[e];
+            auto it = dist.find(a.para);
+            if (it == dist.end() || d + a.peso < it->second.first) {
+                dist[a.para] = {d + a.peso, v};
+                heap.push({d + a.peso, a.para});
+            }
+        }
+    }
+    metricaRegistrar(MET_ROTA_NOS, assentados);
+    if (topo == -1) return r;
+
+    // Subida: origem -> topo (pelos predecessores), depois descida até o hospital
+    vector<int> subida;
+    for (int v = topo; v != -1; v = dist[v].second) subida.push_back(v);
+    reverse(subida.begin(), subida.end());
+
+    r.caminho.push_back(inicio);
+    for (size_t i = 1; i < subida.size(); i++)
+        chDesempacotar(ch, subida[i - 1], subida[i], r.caminho);
+    for (int v = topo; ch.arestaDesce[v] != -1;) {
+        int prox = ch.desce[ch.arestaDesce[v]].para;
+        chDesempacotar(ch, v, prox, r.caminho);
+        v = prox;
+    }
+    r.hospital = r.caminho.back();
+    r.custo = melhor;
+    return r;
+}
+
+/* ===========================
+   ALCANCE (COMPONENTES FORTES)
+=========================== */
+// Condensação do grafo em componentes fortemente conexas (Tarjan iterativo),
+// com uma marca por componente: alguma cidade dela chega a um hospital. Uma
+// cidade sem acesso é respondida em O(1), sem explorar tudo o que ela
+// alcança, e o relatório de regiões sem acesso sai direto das componentes.
+//
+// O índice é mantido pelo lado da escrita a cada cadastro (e refeito por
+// inteiro na importação e ao materializar um snapshot), então a consulta
+// só lê. Como só se cadastram cidades e vias, a marca só passa de falsa a
+// verdadeira: uma via o -> d com d marcada marca a componente de o e se
+// propaga pelas vias de entrada (custo total amortizado O(V + E)). Cidade
+// nova vira uma componente unitária. Uma via entre componentes pode fechar
+// um ciclo e juntar componentes; a partição antiga continua correta para as
+// marcas (cada parte segue fortemente conexa), só fica mais fina, e é
+// refeita (alcanceCondensar) quando o relatório precisa das regiões exatas.
+struct IndiceAlcance {
+    bool condensado = true;         // false: pode haver componentes a juntar
+    vector<int> comp{-1};           // componente de cada cidade
+    vector<uint8_t> alcanca;        // por componente
+    vector<int> membrosInicio{0}, membros; // cidades de cada componente (CSR)
+};
+
+inline IndiceAlcance alcance;
+
+inline void alcanceConstruir(IndiceAlcance &a) {
+    int n = qtdCidades;
+    grafoCompactar(grafo);
+    a = IndiceAlcance();
+    a.comp.assign(n + 1, -1);
+    a.membros.reserve(n);
+    vector<int> ordem(n + 1, -1), menor(n + 1), pilha;
+    vector<uint8_t> naPilha(n + 1, 0);
+    vector<pair<int, int>> chamadas; // (cidade, próxima via a examinar)
+    int contador = 0;
+
+    for (int raiz = 1; raiz <= n; raiz++) {
+        if (ordem[raiz] != -1) continue;
+        auto visitar = [&](int v) {
+            ordem[v] = menor[v] = contador++;
+            pilha.push_back(v);
+            naPilha[v] = 1;
+            chamadas.push_back({v, grafo.inicio[v]});
+        };
+        visitar(raiz);
+        while (!chamadas.empty()) {
+            int v = chamadas.back().first, e = chamadas.back().second;
+            if (e < grafo.inicio[v + 1]) {
+                chamadas.back().second++;
+                int w = grafo.destino[e];
+                if (ordem[w] == -1) visitar(w);
+                else if (naPilha[w]) menor[v] = min(menor[v], ordem[w]);
+                continue;
+            }
+            chamadas.pop_back();
+            if (!chamadas.empty()) {
+                int pai = chamadas.back().first;
+                menor[pai] = min(menor[pai], menor[v]);
+            }
+            if (menor[v] != ordem[v]) continue;
+
+            // v é raiz de uma componente. Tarjan as emite em ordem
+            // topológica reversa: as que ela alcança já têm a marca.
+            int c = (int)a.alcanca.size(), w;
+            size_t ini = a.membros.size();
+            do {
+                w = pilha.back();
+                pilha.pop_back();
+                naPilha[w] = 0;
+                a.comp[w] = c;
+                a.membros.push_back(w);
+            } while (w != v);
+            bool chega = false;
+            for (size_t i = ini; i < a.membros.size() && !chega; i++) {
+                int u = a.membros[i];
+                chega = hospital[u];
+                for (int f = grafo.inicio[u]; f < grafo.inicio[u + 1] && !chega; f++) {
+                    int x = grafo.destino[f];
+                    chega = a.comp[x] != c && a.alcanca[a.comp[x]];
+                }
+            }
+            a.alcanca.push_back(chega);
+            a.membrosInicio.push_back((int)a.membros.size());
+        }
+    }
+}
+
+// A componente c passou a alcançar um hospital: marca quem chega nela
+inline void alcanceMarcar(IndiceAlcance &a, int c) {
+    vector<int> fila{c};
+    a.alcanca[c] = 1;
+    while (!fila.empty()) {
+        int x = fila.back();
+        fila.pop_back();
+        for (int i = a.membrosInicio[x]; i < a.membrosInicio[x + 1]; i++) {
+            paraCadaVizinho(grafoReverso, a.membros[i], [&](int u, int) {
+                int cu = a.comp[u];
+                if (!a.alcanca[cu]) {
+                    a.alcanca[cu] = 1;
+                    fila.push_back(cu);
+                }
+            });
+        }
+    }
+}
+
+inline void alcanceNovaCidade(IndiceAlcance &a, int id) {
+    a.comp.resize(id + 1);
+    a.comp[id] = (int)a.alcanca.size();
+    a.alcanca.push_back(hospital[id]);
+    a.membros.push_back(id);
+    a.membrosInicio.push_back((int)a.membros.size());
+}
+
+inline void alcanceNovaVia(IndiceAlcance &a, int o, int d) {
+    int co = a.comp[o], cd = a.comp[d];
+    if (co == cd) return;
+    a.condensado = false;
+    if (a.alcanca[cd] && !a.alcanca[co]) alcanceMarcar(a, co);
+}
+
+// Junta as componentes que vias novas possam ter unido (lado da escrita)
+inline void alcanceCondensar(IndiceAlcance &a) {
+    if (!a.condensado) alcanceConstruir(a);
+}
+
+// Se a cidade chega a algum hospital (estruturas em memória); só leitura
+inline bool alcancaHospital(int v) {
+    return alcance.alcanca[alcance.comp[v]];
+}
+
+// Regiões (componentes fortes) sem acesso a hospital, da maior para a menor;
+// empates pela menor cidade. O índice precisa estar condensado.
+inline vector<vector<int>> regioesSemHospital(const IndiceAlcance &a) {
+    vector<vector<int>> res;
+    for (size_t c = 0; c < a.alcanca.size(); c++) {
+        if (a.alcanca[c]) continue;
+        res.emplace_back(a.membros.begin() + a.membrosInicio[c], a.membros.begin() + a.membrosInicio[c + 1]);
+        sort(res.back().begin(), res.back().end());
+    }
+    sort(res.begin(), res.end(), [](const vector<int> &x, const vector<int> &y) {
+        return x.size() != y.size() ? x.size() > y.size() : x[0] < y[0];
+    });
+    return res;
+}
+
+// Do estado em memória; condensa o índice antes, se preciso
+inline vector<vector<int>> regioesSemHospital() {
+    alcanceCondensar(alcance);
+    return regioesSemHospital(alcance);
+}
+
+/* ===========================
+   CACHE DE HOSPITAIS ALTERNATIVOS
+=========================== */
+// Guarda, por cidade de origem e critério (tempo ou trechos), os k hospitais
+// mais próximos já calculados. Com vias só sendo incluídas ou encurtadas, as
+// distâncias só diminuem, e um resultado só pode mudar por uma via que saia
+// de uma cidade assentada pela busca (a "bola" até o k-ésimo hospital): de
+// fora dela, qualquer caminho novo já parte de uma distância maior ou igual
+// à do k-ésimo. Um mapa inverso cidade -> origens cujas bolas a contêm
+// invalida só essas entradas. Cidade nova não tem vias de entrada e não
+// afeta nada. Buscas com bola maior que LIMITE_BOLA não entram no cache.
+// O cache global serve o estado em memória, do lado do escritor (menu e
+// servidor); as versões publicadas têm o seu, sob trava (registro_saude.h).
+const size_t LIMITE_BOLA = 1 << 14;
+
+struct EntradaCacheHospitais {
+    bool valida = false;
+    int k = 0;                  // k da busca que gerou as rotas
+    uint32_t geracao = 0;
+    vector<RotaHospital> rotas;
+};
+
+struct CacheHospitais {
+    vector<EntradaCacheHospitais> entradas;            // 2 * origem + trechos
+    vector<vector<pair<uint32_t, uint32_t>>> inverso;  // cidade -> (entrada, geração)
+    uint32_t geracao = 0;
+};
+
+inline CacheHospitais cacheHospitais;
+
+inline void cacheHospitaisNovaVia(CacheHospitais &c, int o) {
+    if ((size_t)o >= c.inverso.size()) return;
+    for (auto [e, g] : c.inverso[o])
+        if (c.entradas[e].geracao == g) c.entradas[e].valida = false;
+    c.inverso[o].clear();
+}
+
+// Chave de (origem, critério) nas entradas
+inline size_t chaveCacheHospitais(int inicio, bool trechos) {
+    return 2 * (size_t)inicio + trechos;
+}
+
+// Copia para res as rotas guardadas, se a entrada cobre os k pedidos
+inline bool cacheHospitaisBuscar(const CacheHospitais &c, size_t chave, int k,
+                                 vector<RotaHospital> &res) {
+    if (chave >= c.entradas.size()) return false;
+    const EntradaCacheHospitais &e = c.entradas[chave];
+    if (!e.valida || (e.k < k && (int)e.rotas.size() >= e.k)) return false;
+    res.assign(e.rotas.begin(), e.rotas.begin() + min<size_t>(k, e.rotas.size()));
+    return true;
+}
+
+// Guarda as rotas de uma busca e a sua bola (cidades assentadas); n é o
+// total de cidades do mapa em que a busca rodou
+inline void cacheHospitaisGuardar(CacheHospitais &c, size_t chave, int k, int n,
+                                  const vector<RotaHospital> &rotas, const vector<int> &bola) {
+    if (bola.size() > LIMITE_BOLA) return;
+    if (c.entradas.size() <= chave) c.entradas.resize(2 * (size_t)n + 2);
+    EntradaCacheHospitais &e = c.entradas[chave];
+    e.valida = true;
+    e.k = k;
+    e.geracao = ++c.geracao;
+    e.rotas = rotas;
+    if (c.inverso.size() < (size_t)n + 1) c.inverso.resize(n + 1);
+    for (int v : bola) c.inverso[v].push_back({(uint32_t)chave, e.geracao});
+}
+
+/* ===========================
+   SAÍDA BUFFERIZADA
+=========================== */
+// Listagens longas são formatadas num buffer reaproveitado e enviadas ao
+// cout em blocos grandes, em vez de um flush (endl) por campo.
+const size_t TAM_SAIDA = 64 * 1024;
+
+struct SaidaBuffer {
+    string proprio;
+    string &buf;
+    bool paraCout = true;
+
+    SaidaBuffer() : buf(proprio) { buf.reserve(TAM_SAIDA + 256); }
+    // Só acumula em destino, sem enviar ao cout (respostas do servidor)
+    explicit SaidaBuffer(string &destino) : buf(destino), paraCout(false) {}
+    ~SaidaBuffer() { descarregar(); }
+
+    void descarregar() {
+        if (!paraCout || buf.empty()) return;
+        Cronometro cron(MET_SAIDA);
+        cout.write(buf.data(), buf.size());
+        buf.clear();
+    }
+    void verificar() {
+        if (paraCout && buf.size() >= TAM_SAIDA) descarregar();
+    }
+    SaidaBuffer& operator<<(string_view s) {
+        buf.append(s.data(), s.size());
+        verificar();
+        return *this;
+    }
+    SaidaBuffer& operator<<(const char *s) { return *this << string_view(s); }
+    SaidaBuffer& operator<<(char c) {
+        buf.push_back(c);
+        return *this;
+    }
+    SaidaBuffer& operator<<(double v) {
+        char tmp[32];
+        int n = snprintf(tmp, sizeof tmp, "%g", v); // mesmo formato padrão do cout
+        return *this << string_view(tmp, n);
+    }
+    template <class T, class = enable_if_t<is_integral_v<T> && !is_same_v<T, char>>>
+    SaidaBuffer& operator<<(T v) {
+        char tmp[24];
+        auto r = to_chars(tmp, tmp + sizeof tmp, v);
+        return *this << string_view(tmp, r.ptr - tmp);
+    }
+};
+
+/* ===========================
+   ESTRUTURAS DE PROFISSIONAIS
+=========================== */
+// Especialidades internadas: o registro guarda só o índice nesta tabela
+typedef uint8_t IdEsp;
+const int QTD_ESPECIALIDADES = 8;
+const char *const ESPECIALIDADES[QTD_ESPECIALIDADES] = {
+    "Clinico Geral", "Cardiologia", "Pediatria", "Ortopedia",
+    "Neurologia", "Dermatologia", "Psiquiatria", "Ginecologia"
+};
+
+// O nome aponta para o arena do cadastro e nunca muda de endereço
+struct Profissional {
+    string_view nome;
+    IdEsp especialidade;
+    int crm;
+    Coord pos;
+};
+
+typedef uint32_t IdProf; // posição do registro no cadastro
+const IdProf SEM_ID = UINT32_MAX;
+
+/* ===========================
+   CADASTRO DE PROFISSIONAIS
+=========================== */
+// Um único armazenamento contíguo de registros; todos os índices guardam
+// apenas o ID de 32 bits. Os textos ficam num arena de blocos fixos, então
+// os string_view continuam válidos quando o vetor de registros cresce.
+const size_t TAM_BLOCO_TEXTO = 64 * 1024;
+
+struct ArenaTexto {
+    vector<unique_ptr<char[]>> blocos;
+    size_t usado = TAM_BLOCO_TEXTO; // força a alocação no primeiro uso
+};
+
+struct CadastroProfissionais {
+    vector<Profissional> registros;
+    ArenaTexto textos;
+};
+
+inline CadastroProfissionais cadastro;
+
+inline string_view arenaGuardar(ArenaTexto &a, string_view s) {
+    if (s.size() > TAM_BLOCO_TEXTO) {
+        // Texto maior que um bloco ganha um bloco só para ele; o bloco em uso
+        // continua no fim da lista
+        a.blocos.emplace_back(new char[s.size()]);
+        char *dest = a.blocos.back().get();
+        if (a.blocos.size() > 1) swap(a.blocos.back(), a.blocos[a.blocos.size() - 2]);
+        copy(s.begin(), s.end(), dest);
+        return string_view(dest, s.size());
+    }
+    if (a.usado + s.size() > TAM_BLOCO_TEXTO) {
+        a.blocos.emplace_back(new char[TAM_BLOCO_TEXTO]);
+        a.usado = 0;
+    }
+    char *dest = a.blocos.back().get() + a.usado;
+    copy(s.begin(), s.end(), dest);
+    a.usado += s.size();
+    return string_view(dest, s.size());
+}
+
+inline const Profissional& prof(IdProf id) {
+    return cadastro.registros[id];
+}
+
+inline IdProf cadastroInserir(CadastroProfissionais &c, string_view nome, IdEsp esp,
+                       int crm, Coord pos) {
+    Profissional p;
+    p.nome = arenaGuardar(c.textos, nome);
+    p.especialidade = esp;
+    p.crm = crm;
+    p.pos = pos;
+    c.registros.push_back(p);
+    return (IdProf)c.registros.size() - 1;
+}
+
+// Libera todos os registros e textos de uma vez
+inline void cadastroLiberar(CadastroProfissionais &c) {
+    c = CadastroProfissionais();
+}
+
+/* ===========================
+   ÁRVORES B+
+=========================== */
+// Índice ordenado por nome. Cada nó guarda até
+// ORDEM_B chaves contíguas; as folhas são encadeadas para permitir percorrer
+// em ordem sem recursão. Altura O(log n) garantida, independente da ordem
+// de inserção. Chaves repetidas são permitidas e mantêm a ordem de chegada.
+const int ORDEM_B = 32;
+
+struct NoB {
+    bool folha;
+    int qtd = 0;
+    string_view chaves[ORDEM_B];      // apontam para o arena do cadastro
+    IdProf valores[ORDEM_B];          // só nas folhas
+    NoB *filhos[ORDEM_B + 1];         // só nos nós internos
+    NoB *prox = NULL;                 // próxima folha
+};
+
+// Os nós vêm de um pool da própria árvore (endereços estáveis em deque),
+// liberado de uma só vez
+struct ArvoreB {
+    NoB *raiz = NULL;
+    size_t tamanho = 0;
+    deque<NoB> nos;
+};
+
+inline NoB* arvoreNovoNo(ArvoreB &a, bool folha) {
+    a.nos.emplace_back();
+    a.nos.back().folha = folha;
+    return &a.nos.back();
+}
+
+inline ArvoreB arvoreNome;
+
+// Divide o filho cheio na posição i do nó interno pai
+inline void arvoreDividirFilho(ArvoreB &a, NoB *pai, int i) {
+    NoB *esq = pai->filhos[i];
+    NoB *dir = arvoreNovoNo(a, esq->folha);
+    int meio = ORDEM_B / 2;
+    string_view separador;
+
+    if (esq->folha) {
+        // A folha direita fica com a metade superior; o separador é copiado
+        for (int j = meio; j < esq->qtd; j++) {
+            dir->chaves[j - meio] = esq->chaves[j];
+            dir->valores[j - meio] = esq->valores[j];
+        }
+        dir->qtd = esq->qtd - meio;
+        esq->qtd = meio;
+        dir->prox = esq->prox;
+        esq->prox = dir;
+        separador = dir->chaves[0];
+    } else {
+        // No nó interno a chave do meio sobe para o pai
+        for (int j = meio + 1; j < esq->qtd; j++)
+            dir->chaves[j - meio - 1] = esq->chaves[j];
+        for (int j = meio + 1; j <= esq->qtd; j++)
+            dir->filhos[j - meio - 1] = esq->filhos[j];
+        dir->qtd = esq->qtd - meio - 1;
+        separador = esq->chaves[meio];
+        esq->qtd = meio;
+    }
+
+    for (int j = pai->qtd; j > i; j--) {
+        pai->chaves[j] = pai->chaves[j - 1];
+        pai->filhos[j + 1] = pai->filhos[j];
+    }
+    pai->chaves[i] = separador;
+    pai->filhos[i + 1] = dir;
+    pai->qtd++;
+}
+
+// Inserção iterativa: nós cheios são divididos na descida
+inline void arvoreInserir(ArvoreB &a, string_view chave, IdProf valor) {
+    if (!a.raiz) a.raiz = arvoreNovoNo(a, true);
+    if (a.raiz->qtd == ORDEM_B) {
+        NoB *novaRaiz = arvoreNovoNo(a, false);
+        novaRaiz->filhos[0] = a.raiz;
+        arvoreDividirFilho(a, novaRaiz, 0);
+        a.raiz = novaRaiz;
+    }
+
+    NoB *atual = a.raiz;
+    while (!atual->folha) {
+        // Desce à direita das chaves iguais (upper_bound)
+        int i = upper_bound(atual->chaves, atual->chaves + atual->qtd, chave) - atual->chaves;
+        if (atual->filhos[i]->qtd == ORDEM_B) {
+            arvoreDividirFilho(a, atual, i);
+            if (!(chave < atual->chaves[i])) i++;
+        }
+        atual = atual->filhos[i];
+    }
+
+    int pos = upper_bound(atual->chaves, atual->chaves + atual->qtd, chave) - atual->chaves;
+    for (int j = atual->qtd; j > pos; j--) {
+        atual->chaves[j] = move(atual->chaves[j - 1]);
+        atual->valores[j] = atual->valores[j - 1];
+    }
+    atual->chaves[pos] = chave;
+    atual->valores[pos] = valor;
+    atual->qtd++;
+    a.tamanho++;
+}
+
+// Primeira posição (folha, índice) com chave >= 'chave'; folha NULL = fim
+inline pair<NoB*, int> arvoreLimiteInferior(const ArvoreB &a, string_view chave,
+                                            int *visitados = NULL) {
+    NoB *atual = a.raiz;
+    if (!atual) return {NULL, 0};
+    int nos = 1;
+    while (!atual->folha) {
+        int i = lower_bound(atual->chaves, atual->chaves + atual->qtd, chave) - atual->chaves;
+        atual = atual->filhos[i];
+        nos++;
+    }
+    if (visitados) *visitados = nos;
+    int pos = lower_bound(atual->chaves, atual->chaves + atual->qtd, chave) - atual->chaves;
+    // Repetições podem ter ficado à esquerda do separador: avança de folha
+    while (atual && pos == atual->qtd) {
+        atual = atual->prox;
+        pos = 0;
+    }
+    return {atual, pos};
+}
+
+inline IdProf arvoreBuscar(const ArvoreB &a, string_view chave) {
+    Cronometro cron(MET_BUSCA_NOME);
+    int nos = 0;
+    auto [folha, pos] = arvoreLimiteInferior(a, chave, &nos);
+    metricaRegistrar(MET_BUSCA_NOME_NOS, nos);
+    if (folha && folha->chaves[pos] == chave) return folha->valores[pos];
+    return SEM_ID;
+}
+
+// Chama f(id) em ordem crescente de chave
+template <class F>
+void arvorePercorrer(const ArvoreB &a, F f) {
+    NoB *atual = a.raiz;
+    if (!atual) return;
+    while (!atual->folha) atual = atual->filhos[0];
+    for (; atual; atual = atual->prox)
+        for (int i = 0; i < atual->qtd; i++)
+            f(atual->valores[i]);
+}
+
+// Montagem de baixo para cima a partir de pares já ordenados: folhas com 3/4
+// da capacidade (sobra espaço para inserções), depois cada nível interno
+inline void arvoreConstruir(ArvoreB &a, const vector<pair<string_view, IdProf>> &ordenados) {
+    a = ArvoreB();
+    if (ordenados.empty()) return;
+    const int CHEIO = ORDEM_B * 3 / 4;
+
+    vector<NoB*> nivel;
+    vector<string_view> menor; // menor chave de cada nó do nível
+    NoB *anterior = NULL;
+    for (size_t i = 0; i < ordenados.size(); i += CHEIO) {
+        NoB *folha = arvoreNovoNo(a, true);
+        size_t fim = min(ordenados.size(), i + CHEIO);
+        for (size_t j = i; j < fim; j++) {
+            folha->chaves[folha->qtd] = ordenados[j].first;
+            folha->valores[folha->qtd++] = ordenados[j].second;
+        }
+        if (anterior) anterior->prox = folha;
+        anterior = folha;
+        nivel.push_back(folha);
+        menor.push_back(folha->chaves[0]);
+    }
+
+    while (nivel.size() > 1) {
+        vector<NoB*> acima;
+        vector<string_view> menorAcima;
+        for (size_t i = 0; i < nivel.size(); i += CHEIO + 1) {
+            NoB *no = arvoreNovoNo(a, false);
+            size_t fim = min(nivel.size(), i + CHEIO + 1);
+            no->filhos[0] = nivel[i];
+            for (size_t j = i + 1; j < fim; j++) {
+                no->chaves[no->qtd++] = menor[j];
+                no->filhos[no->qtd] = nivel[j];
+            }
+            acima.push_back(no);
+            menorAcima.push_back(menor[i]);
+        }
+        nivel.swap(acima);
+        menor.swap(menorAcima);
+    }
+    a.raiz = nivel[0];
+    a.tamanho = ordenados.size();
+}
+
+// Os nós saem todos juntos com o pool
+inline void arvoreLiberar(ArvoreB &a) {
+    a = ArvoreB();
+}
+
+/* --- Cursores --- */
+// Posição numa folha; permite paginar "a partir da chave X, me dê N"
+// sem materializar nem imprimir o resto do índice
+struct CursorNome {
+    NoB *folha = NULL;
+    int pos = 0;
+};
+
+// Cursor no primeiro nome estritamente maior que 'apos' ("" = início)
+inline CursorNome cursorNomeApos(const ArvoreB &a, string_view apos) {
+    auto [folha, pos] = arvoreLimiteInferior(a, apos);
+    CursorNome c{folha, pos};
+    while (c.folha && !apos.empty() && c.folha->chaves[c.pos] == apos) {
+        if (++c.pos == c.folha->qtd) {
+            c.folha = c.folha->prox;
+            c.pos = 0;
+        }
+    }
+    return c;
+}
+
+inline bool cursorNomeProximo(CursorNome &c, IdProf &id) {
+    if (!c.folha) return false;
+    id = c.folha->valores[c.pos];
+    if (++c.pos == c.folha->qtd) {
+        c.folha = c.folha->prox;
+        c.pos = 0;
+    }
+    return true;
+}
+
+inline vector<IdProf> paginaPorNome(const ArvoreB &a, string_view apos, size_t n) {
+    Cronometro cron(MET_PAGINA);
+    vector<IdProf> res;
+    CursorNome c = cursorNomeApos(a, apos);
+    IdProf id;
+    while (res.size() < n && cursorNomeProximo(c, id)) res.push_back(id);
+    return res;
+}
+
+/* ===========================
+   BUSCA POR NOME PARCIAL
+=========================== */
+// Segunda árvore B+, com o nome normalizado como chave: minúsculas, sem
+// acentos (UTF-8 de U+00C0 a U+00FF) e com espaços repetidos reduzidos a um.
+// As chaves ficam num arena próprio. A busca por prefixo é um limite
+// inferior seguido de leitura das folhas. A busca aproximada percorre as
+// chaves em ordem como se fosse uma trie: guarda uma linha da matriz de
+// edição por caractere do prefixo comum com a chave anterior e, quando o
+// menor valor de uma linha passa do limite, salta para a primeira chave que
+// não começa com aquele prefixo. Mantida a cada cadastro e remontada de uma
+// vez na importação e ao materializar um snapshot, então a busca só lê.
+// As versões publicadas levam as mesmas chaves num array ordenado
+// (ImagemProfissionais), percorrido pelo mesmo algoritmo.
+const int MAX_DIST_EDICAO = 3;
+
+struct IndiceNomesNormalizados {
+    ArvoreB arvore;
+    ArenaTexto textos;
+};
+
+inline IndiceNomesNormalizados nomesNormalizados;
+
+// Letra base para o segundo byte de U+00C0..U+00FF (C3 80..C3 BF); '*'
+// mantém o caractere
+const char SEM_ACENTO[65] = "aaaaaa*ceeeeiiiidnooooo*ouuuuy**aaaaaa*ceeeeiiiidnooooo*ouuuuy*y";
+
+inline void normalizarNome(string_view s, string &dest) {
+    dest.clear();
+    for (size_t i = 0; i < s.size(); i++) {
+        unsigned char ch = s[i];
+        if (ch == ' ' || ch == '\t') {
+            if (!dest.empty() && dest.back() != ' ') dest += ' ';
+        } else if (ch == 0xC3 && i + 1 < s.size() && (unsigned char)s[i + 1] >= 0x80 &&
+                   (unsigned char)s[i + 1] <= 0xBF && SEM_ACENTO[(unsigned char)s[i + 1] - 0x80] != '*') {
+            dest += SEM_ACENTO[(unsigned char)s[++i] - 0x80];
+        } else {
+            dest += (char)tolower(ch);
+        }
+    }
+    if (!dest.empty() && dest.back() == ' ') dest.pop_back();
+}
+
+inline void nomesNormalizadosInserir(IndiceNomesNormalizados &ix, IdProf id) {
+    static thread_local string chave;
+    normalizarNome(prof(id).nome, chave);
+    arvoreInserir(ix.arvore, arenaGuardar(ix.textos, chave), id);
+}
+
+inline void nomesNormalizadosConstruir(IndiceNomesNormalizados &ix) {
+    ix = IndiceNomesNormalizados();
+    vector<pair<string_view, IdProf>> pares;
+    pares.reserve(cadastro.registros.size());
+    string chave;
+    // Em ordem de nome original, para que as chaves iguais fiquem em ordem
+    // estável, como na árvore de nomes
+    arvorePercorrer(arvoreNome, [&](IdProf id) {
+        normalizarNome(prof(id).nome, chave);
+        pares.push_back({arenaGuardar(ix.textos, chave), id});
+    });
+    stable_sort(pares.begin(), pares.end(),
+                [](const auto &a, const auto &b) { return a.first < b.first; });
+    arvoreConstruir(ix.arvore, pares);
+}
+
+// Menor chave maior que todas as que começam com p ("" = nenhuma)
+inline string sucessorPrefixo(string_view p) {
+    string s(p);
+    while (!s.empty() && (unsigned char)s.back() == 0xFF) s.pop_back();
+    if (!s.empty()) s.back()++;
+    return s;
+}
+
+// Cursores sobre chaves normalizadas em ordem, para as buscas abaixo: a
+// árvore do estado em memória ou o array ordenado de uma versão publicada.
+// saltar(p) vai para a primeira chave, a partir da atual, que não começa
+// com p.
+struct CursorChavesArvore {
+    const ArvoreB *a;
+    CursorNome c;
+
+    CursorChavesArvore(const ArvoreB &arvore, string_view inicio) : a(&arvore) {
+        auto [folha, pos] = arvoreLimiteInferior(arvore, inicio);
+        c = CursorNome{folha, pos};
+    }
+    bool fim() const { return !c.folha; }
+    string_view chave() const { return c.folha->chaves[c.pos]; }
+    IdProf id() const { return c.folha->valores[c.pos]; }
+    void avancar() {
+        IdProf id;
+        cursorNomeProximo(c, id);
+    }
+    // Pula as que restam na folha e, se a folha acabar, desce de novo
+    void saltar(string_view p) {
+        while (c.pos < c.folha->qtd && c.folha->chaves[c.pos].substr(0, p.size()) == p) c.pos++;
+        if (c.pos < c.folha->qtd) return;
+        string prox = sucessorPrefixo(p);
+        if (prox.empty()) c.folha = NULL;
+        else *this = CursorChavesArvore(*a, prox);
+    }
+};
+
+// Chave i em texto[inicio[i] .. inicio[i + 1]), com o ID em ids[i]
+struct CursorChavesOrdenadas {
+    const char *texto;
+    const uint32_t *inicio;
+    const IdProf *ids;
+    size_t qtd, i;
+
+    string_view chaveEm(size_t j) const {
+        return string_view(texto + inicio[j], inicio[j + 1] - inicio[j]);
+    }
+    // Primeira posição a partir de i com chave >= k
+    size_t limiteInferior(string_view k) const {
+        size_t lo = i, hi = qtd;
+        while (lo < hi) {
+            size_t meio = lo + (hi - lo) / 2;
+            if (chaveEm(meio) < k) lo = meio + 1;
+            else hi = meio;
+        }
+        return lo;
+    }
+
+    CursorChavesOrdenadas(const char *texto, const uint32_t *inicio, const IdProf *ids, size_t qtd,
+                          string_view primeira)
+        : texto(texto), inicio(inicio), ids(ids), qtd(qtd), i(0) {
+        i = limiteInferior(primeira);
+    }
+    bool fim() const { return i >= qtd; }
+    string_view chave() const { return chaveEm(i); }
+    IdProf id() const { return ids[i]; }
+    void avancar() { i++; }
+    void saltar(string_view p) {
+        string prox = sucessorPrefixo(p);
+        i = prox.empty() ? qtd : limiteInferior(prox);
+    }
+};
+
+// Até n profissionais cujo nome normalizado começa com o prefixo p (já
+// normalizado), em ordem de nome; c começa em p
+template <class Cursor>
+vector<IdProf> buscaPrefixo(Cursor c, string_view p, size_t n) {
+    vector<IdProf> res;
+    for (; res.size() < n && !c.fim() && c.chave().substr(0, p.size()) == p; c.avancar())
+        res.push_back(c.id());
+    return res;
+}
+
+inline vector<IdProf> buscarPrefixo(string_view prefixo, size_t n) {
+    Cronometro cron(MET_BUSCA_PREFIXO);
+    string p;
+    normalizarNome(prefixo, p);
+    return buscaPrefixo(CursorChavesArvore(nomesNormalizados.arvore, p), p, n);
+}
+
+struct NomeAproximado {
+    IdProf id;
+    int distancia;
+};
+
+// Até n profissionais a no máximo maxDist edições (inserção, remoção ou
+// troca de um caractere) do nome, após normalizar os dois lados; ordenados
+// por distância e depois por nome. c começa na primeira chave.
+template <class Cursor>
+vector<NomeAproximado> buscaAproximada(Cursor c, string_view nome, int maxDist, size_t n) {
+    maxDist = max(0, min(maxDist, MAX_DIST_EDICAO));
+    string q;
+    normalizarNome(nome, q);
+    const int m = (int)q.size();
+
+    // linhas[j] = distâncias entre os j primeiros caracteres da chave e cada
+    // prefixo da consulta; só as 'validas' primeiras linhas valem para a
+    // chave atual. Cada linha só calcula a faixa |i - j| <= maxDist; as
+    // posições vizinhas da faixa guardam maxDist + 1 ("acima do limite")
+    const int acima = maxDist + 1;
+    vector<vector<int>> linhas(1, vector<int>(m + 1));
+    for (int i = 0; i <= m; i++) linhas[0][i] = i;
+    string anterior;
+    size_t validas = 1;
+    vector<pair<int, size_t>> achados; // (distância, posição em ordem de nome)
+    vector<IdProf> ids;
+
+    while (!c.fim()) {
+        string_view chave = c.chave();
+        size_t comum = 0;
+        while (comum < anterior.size() && comum < chave.size() && comum + 1 < validas &&
+               anterior[comum] == chave[comum])
+            comum++;
+        validas = comum + 1;
+        bool podado = false;
+        for (size_t j = comum; j < chave.size(); j++) {
+            if (linhas.size() <= j + 1) linhas.emplace_back(m + 1);
+            const vector<int> &ant = linhas[j];
+            vector<int> &lin = linhas[j + 1];
+            int lo = max(1, (int)j + 1 - maxDist), hi = min(m, (int)j + 1 + maxDist);
+            lin[0] = (int)j + 1;
+            if (lo - 1 >= 1 && lo - 1 <= m) lin[lo - 1] = acima;
+            if (hi + 1 <= m) lin[hi + 1] = acima;
+            int menor = lo == 1 ? lin[0] : acima;
+            for (int i = lo; i <= hi; i++) {
+                lin[i] = min({ant[i] + 1, lin[i - 1] + 1, ant[i - 1] + (q[i - 1] != chave[j])});
+                menor = min(menor, lin[i]);
+            }
+            validas = j + 2;
+            if (menor > maxDist) {
+                // Nenhuma chave com este prefixo serve
+                anterior.assign(chave.substr(0, j + 1));
+                c.saltar(anterior);
+                podado = true;
+                break;
+            }
+        }
+        if (podado) continue;
+        anterior.assign(chave);
+        IdProf id = c.id();
+        c.avancar();
+        int d = abs((int)chave.size() - m) <= maxDist ? linhas[chave.size()][m] : acima;
+        if (d <= maxDist) {
+            achados.push_back({d, ids.size()});
+            ids.push_back(id);
+        }
+    }
+
+    size_t qtd = min(n, achados.size());
+    partial_sort(achados.begin(), achados.begin() + qtd, achados.end());
+    vector<NomeAproximado> res(qtd);
+    for (size_t i = 0; i < qtd; i++) res[i] = {ids[achados[i].second], achados[i].first};
+    return res;
+}
+
+inline vector<NomeAproximado> buscarAproximado(string_view nome, int maxDist, size_t n) {
+    Cronometro cron(MET_BUSCA_APROXIMADA);
+    return buscaAproximada(CursorChavesArvore(nomesNormalizados.arvore, string_view()), nome, maxDist, n);
+}
+
+/* ===========================
+   ÍNDICE DE CRM (HASH)
+=========================== */
+// Tabela de endereçamento aberto (sondagem linear) com capacidade potência
+// de 2 e fator de carga de no máximo 1/2: busca e inserção O(1) esperado.
+struct IndiceCRM {
+    vector<int> chaves;
+    vector<IdProf> valores;          // SEM_ID = posição livre
+    size_t tamanho = 0;
+};
+
+inline IndiceCRM indiceCRM;
+
+inline size_t crmPosicao(size_t capacidade, int crm) {
+    // Mistura de bits (multiplicação de Fibonacci) antes de mascarar
+    return (size_t)(((unsigned long long)(unsigned int)crm * 11400714819323198485ull) >> 32)
+           & (capacidade - 1);
+}
+
+// Sondagem sobre os arrays crus: serve à tabela em memória e às cópias
+// publicadas em snapshots
+inline IdProf crmSondar(const int *chaves, const IdProf *valores, size_t capacidade, int crm) {
+    Cronometro cron(MET_BUSCA_CRM);
+    IdProf res = SEM_ID;
+    uint64_t sondas = 0;
+    if (capacidade > 0) {
+        for (size_t i = crmPosicao(capacidade, crm);; i = (i + 1) & (capacidade - 1)) {
+            sondas++;
+            if (valores[i] == SEM_ID) break;
+            if (chaves[i] == crm) {
+                res = valores[i];
+                break;
+            }
+        }
+    }
+    metricaRegistrar(MET_BUSCA_CRM_SONDAS, sondas);
+    return res;
+}
+
+inline IdProf crmBuscar(const IndiceCRM &h, int crm) {
+    return crmSondar(h.chaves.data(), h.valores.data(), h.chaves.size(), crm);
+}
+
+inline void crmInserir(IndiceCRM &h, int crm, IdProf id);
+
+inline void crmRedimensionar(IndiceCRM &h, size_t capacidade) {
+    IndiceCRM novo;
+    novo.chaves.assign(capacidade, 0);
+    novo.valores.assign(capacidade, SEM_ID);
+    for (size_t i = 0; i < h.chaves.size(); i++)
+        if (h.valores[i] != SEM_ID) crmInserir(novo, h.chaves[i], h.valores[i]);
+    h = move(novo);
+}
+
+inline void crmInserir(IndiceCRM &h, int crm, IdProf id) {
+    if (2 * (h.tamanho + 1) > h.chaves.size())
+        crmRedimensionar(h, max<size_t>(16, 2 * h.chaves.size()));
+    size_t i = crmPosicao(h.chaves.size(), crm);
+    while (h.valores[i] != SEM_ID) i = (i + 1) & (h.chaves.size() - 1);
+    h.chaves[i] = crm;
+    h.valores[i] = id;
+    h.tamanho++;
+}
+
+inline bool crmExiste(int crm) {
+    return crmBuscar(indiceCRM, crm) != SEM_ID;
+}
+
+/* ===========================
+   KERNEL DE DISTÂNCIA (SIMD)
+=========================== */
+// Filtra n pontos em arrays separados x[] e y[] contra um centro e um raio e
+// grava, em ordem, base + i para cada ponto a até o raio. |dx| e |dy| são
+// calculados sem sinal em 32 bits (max - min, que nunca transborda); quem
+// passa de 'raio' em um eixo já está fora, e nos demais dx² + dy² < 2^63,
+// então a comparação em 64 bits é exata. As versões AVX2 (8 pontos por vez)
+// e SSE4.2 (4 por vez) montam a máscara dos aceitos e compactam os índices
+// com uma tabela de permutação (o equivalente a um compress store); a
+// versão é escolhida na partida conforme a CPU, e fora de x86 só existe a
+// escalar.
+typedef size_t (*KernelRaio)(const int32_t *x, const int32_t *y, size_t n, Coord c, int raio,
+                             uint32_t base, uint32_t *saida);
+
+inline size_t raioEscalar(const int32_t *x, const int32_t *y, size_t n, Coord c, int raio,
+                          uint32_t base, uint32_t *saida) {
+    uint64_t r = (uint64_t)max(raio, 0), r2 = r * r;
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t dx = (uint32_t)(max(x[i], c.x) - (int64_t)min(x[i], c.x));
+        uint64_t dy = (uint32_t)(max(y[i], c.y) - (int64_t)min(y[i], c.y));
+        if (dx <= r && dy <= r && dx * dx + dy * dy <= r2) saida[k++] = base + (uint32_t)i;
+    }
+    return k;
+}
+
+#ifdef SIMD_X86
+// Para cada máscara de 8 (ou 4) bits, a posição de origem de cada índice
+// aceito, em ordem
+struct TabelaCompactacao {
+    uint32_t avx2[256][8];
+    uint8_t sse[16][16];
+};
+
+constexpr TabelaCompactacao montarTabelaCompactacao() {
+    TabelaCompactacao t{};
+    for (int m = 0; m < 256; m++) {
+        int k = 0;
+        for (int i = 0; i < 8; i++)
+            if (m >> i & 1) t.avx2[m][k++] = i;
+    }
+    for (int m = 0; m < 16; m++) {
+        int k = 0;
+        for (int i = 0; i < 4; i++)
+            if (m >> i & 1) {
+                for (int b = 0; b < 4; b++) t.sse[m][4 * k + b] = (uint8_t)(4 * i + b);
+                k++;
+            }
+        for (int b = 4 * k; b < 16; b++) t.sse[m][b] = 0x80; // zera o resto
+    }
+    return t;
+}
+
+inline constexpr TabelaCompactacao TABELA_COMPACTACAO = montarTabelaCompactacao();
+
+__attribute__((target("avx2,popcnt")))
+inline size_t raioAVX2(const int32_t *x, const int32_t *y, size_t n, Coord c, int raio,
+                       uint32_t base, uint32_t *saida) {
+    raio = max(raio, 0);
+    const __m256i cx = _mm256_set1_epi32(c.x), cy = _mm256_set1_epi32(c.y);
+    const __m256i r = _mm256_set1_epi32(raio);
+    const __m256i limite = _mm256_set1_epi64x((long long)raio * raio + 1);
+    const __m256i passo = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    size_t k = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i vx = _mm256_loadu_si256((const __m256i*)(x + i));
+        __m256i vy = _mm256_loadu_si256((const __m256i*)(y + i));
+        __m256i dx = _mm256_sub_epi32(_mm256_max_epi32(vx, cx), _mm256_min_epi32(vx, cx));
+        __m256i dy = _mm256_sub_epi32(_mm256_max_epi32(vy, cy), _mm256_min_epi32(vy, cy));
+        __m256i caixa = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_max_epu32(dx, r), r),
+                                         _mm256_cmpeq_epi32(_mm256_max_epu32(dy, r), r));
+        // Quadrados em 64 bits: posições pares e ímpares em separado
+        __m256i par = _mm256_add_epi64(_mm256_mul_epu32(dx, dx), _mm256_mul_epu32(dy, dy));
+        __m256i dxi = _mm256_srli_epi64(dx, 32), dyi = _mm256_srli_epi64(dy, 32);
+        __m256i impar = _mm256_add_epi64(_mm256_mul_epu32(dxi, dxi), _mm256_mul_epu32(dyi, dyi));
+        __m256i dentro = _mm256_blend_epi32(_mm256_cmpgt_epi64(limite, par),
+                                            _mm256_cmpgt_epi64(limite, impar), 0xAA);
+        int m = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(caixa, dentro)));
+        __m256i ids = _mm256_add_epi32(_mm256_set1_epi32((int)(base + i)), passo);
+        __m256i perm = _mm256_loadu_si256((const __m256i*)TABELA_COMPACTACAO.avx2[m]);
+        _mm256_storeu_si256((__m256i*)(saida + k), _mm256_permutevar8x32_epi32(ids, perm));
+        k += __builtin_popcount(m);
+    }
+    return k + raioEscalar(x + i, y + i, n - i, c, raio, base + (uint32_t)i, saida + k);
+}
+
+__attribute__((target("sse4.2,popcnt")))
+inline size_t raioSSE42(const int32_t *x, const int32_t *y, size_t n, Coord c, int raio,
+                        uint32_t base, uint32_t *saida) {
+    raio = max(raio, 0);
+    const __m128i cx = _mm_set1_epi32(c.x), cy = _mm_set1_epi32(c.y);
+    const __m128i r = _mm_set1_epi32(raio);
+    const __m128i limite = _mm_set1_epi64x((long long)raio * raio + 1);
+    const __m128i passo = _mm_setr_epi32(0, 1, 2, 3);
+    size_t k = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i vx = _mm_loadu_si128((const __m128i*)(x + i));
+        __m128i vy = _mm_loadu_si128((const __m128i*)(y + i));
+        __m128i dx = _mm_sub_epi32(_mm_max_epi32(vx, cx), _mm_min_epi32(vx, cx));
+        __m128i dy = _mm_sub_epi32(_mm_max_epi32(vy, cy), _mm_min_epi32(vy, cy));
+        __m128i caixa = _mm_and_si128(_mm_cmpeq_epi32(_mm_max_epu32(dx, r), r),
+                                      _mm_cmpeq_epi32(_mm_max_epu32(dy, r), r));
+        __m128i par = _mm_add_epi64(_mm_mul_epu32(dx, dx), _mm_mul_epu32(dy, dy));
+        __m128i dxi = _mm_srli_epi64(dx, 32), dyi = _mm_srli_epi64(dy, 32);
+        __m128i impar = _mm_add_epi64(_mm_mul_epu32(dxi, dxi), _mm_mul_epu32(dyi, dyi));
+        __m128i dentro = _mm_blend_epi16(_mm_cmpgt_epi64(limite, par),
+                                         _mm_cmpgt_epi64(limite, impar), 0xCC);
+        int m = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(caixa, dentro)));
+        __m128i ids = _mm_add_epi32(_mm_set1_epi32((int)(base + i)), passo);
+        __m128i perm = _mm_loadu_si128((const __m128i*)TABELA_COMPACTACAO.sse[m]);
+        _mm_storeu_si128((__m128i*)(saida + k), _mm_shuffle_epi8(ids, perm));
+        k += __builtin_popcount(m);
+    }
+    return k + raioEscalar(x + i, y + i, n - i, c, raio, base + (uint32_t)i, saida + k);
+}
+#endif
+
+struct InfoKernel {
+    KernelRaio raio;
+    const char *nome;
+};
+
+inline InfoKernel escolherKernel() {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return {raioAVX2, "avx2"};
+    if (__builtin_cpu_supports("sse4.2")) return {raioSSE42, "sse4.2"};
+#endif
+    return {raioEscalar, "escalar"};
+}
+
+inline const InfoKernel kernelDistancia = escolherKernel();
+
+/* ===========================
+   ÍNDICE ESPACIAL (GRADE UNIFORME)
+=========================== */
+// O plano é dividido em células quadradas de TAM_CELULA unidades (ou 'lado',
+// numa grade que guarde só parte dos pontos); cada célula não vazia guarda,
+// de forma contígua, as coordenadas e o profissional.
+// As distâncias são comparadas ao quadrado, em aritmética inteira.
+// A grade em memória também guarda todos os pontos, na ordem de inserção,
+// em arrays separados x[] e y[]: quando a janela de uma consulta de raio
+// cobre muitas células, é mais barato o kernel de distância varrer esses
+// arrays inteiros do que procurar célula por célula.
+const int TAM_CELULA = 64;
+
+struct EntradaGrade {
+    int x, y;
+    IdProf id;
+};
+
+struct GradeEspacial {
+    int lado = TAM_CELULA;
+    unordered_map<long long, vector<EntradaGrade>> celulas;
+    int minCx = 0, maxCx = -1, minCy = 0, maxCy = -1; // extensão ocupada
+    size_t total = 0;
+    vector<int32_t> x, y; // todos os pontos, na ordem de inserção
+    vector<IdProf> id;
+};
+
+inline GradeEspacial grade;
+
+typedef pair<long long, IdProf> Vizinho; // (distância², profissional)
+
+inline int celulaDe(int v, int lado) {
+    return v >= 0 ? v / lado : -((-(long long)v + lado - 1) / lado);
+}
+
+inline long long chaveCelula(int cx, int cy) {
+    return (long long)(((uint64_t)(uint32_t)cx << 32) | (uint32_t)cy);
+}
+
+// Quadrado de v >= 0, saturado em LLONG_MAX
+inline long long quadradoSaturado(long long v) {
+    return v > 3037000499LL ? LLONG_MAX : v * v; // 3037000499² < 2^63
+}
+
+// Distância² entre pontos de coordenadas int: |dx|, |dy| < 2^32, então cada
+// quadrado cabe em uint64_t, mas a soma chega a 2^65. Acima de LLONG_MAX
+// (distância ~3,04e9) satura, e esses pontos empatam entre si.
+inline long long dist2(Coord a, int x, int y) {
+    uint64_t dx = (uint32_t)(max(a.x, x) - (int64_t)min(a.x, x));
+    uint64_t dy = (uint32_t)(max(a.y, y) - (int64_t)min(a.y, y));
+    uint64_t qx = dx * dx, qy = dy * dy;
+    if (qx >= (uint64_t)LLONG_MAX || qy >= (uint64_t)LLONG_MAX - qx) return LLONG_MAX;
+    return (long long)(qx + qy);
+}
+
+inline void gradeInserir(GradeEspacial &g, Coord pos, IdProf id) {
+    int cx = celulaDe(pos.x, g.lado), cy = celulaDe(pos.y, g.lado);
+    g.celulas[chaveCelula(cx, cy)].push_back({pos.x, pos.y, id});
+    g.x.push_back(pos.x);
+    g.y.push_back(pos.y);
+    g.id.push_back(id);
+    if (g.total++ == 0) {
+        g.minCx = g.maxCx = cx;
+        g.minCy = g.maxCy = cy;
+    } else {
+        g.minCx = min(g.minCx, cx); g.maxCx = max(g.maxCx, cx);
+        g.minCy = min(g.minCy, cy); g.maxCy = max(g.maxCy, cy);
+    }
+}
+
+inline size_t gradeQtdCelulas(const GradeEspacial &g) {
+    return g.celulas.size();
+}
+
+template <class F>
+void gradeVisitarCelula(const GradeEspacial &g, int cx, int cy, F f) {
+    auto it = g.celulas.find(chaveCelula(cx, cy));
+    if (it == g.celulas.end()) return;
+    for (const EntradaGrade &e : it->second) f(e);
+}
+
+template <class F>
+void gradeVisitarTodas(const GradeEspacial &g, F f) {
+    for (const auto &cel : g.celulas)
+        for (const EntradaGrade &e : cel.second) f(e);
+}
+
+// As buscas abaixo servem tanto para a grade em memória quanto para a do
+// snapshot mapeado (VisaoGrade), que oferece as mesmas operações.
+
+// Células [x0, x1] x [y0, y1] que tocam o quadrado de lado 2 * raio centrado
+// em c, cortadas à extensão ocupada
+struct JanelaGrade {
+    long long x0, x1, y0, y1;
+
+    long long celulas() const {
+        return x0 <= x1 && y0 <= y1 ? (x1 - x0 + 1) * (y1 - y0 + 1) : 0;
+    }
+};
+
+template <class G>
+JanelaGrade gradeJanela(const G &g, Coord c, long long raio) {
+    return {max<long long>(celulaDe(max<long long>(c.x - raio, INT_MIN), g.lado), g.minCx),
+            min<long long>(celulaDe(min<long long>(c.x + raio, INT_MAX), g.lado), g.maxCx),
+            max<long long>(celulaDe(max<long long>(c.y - raio, INT_MIN), g.lado), g.minCy),
+            min<long long>(celulaDe(min<long long>(c.y + raio, INT_MAX), g.lado), g.maxCy)};
+}
+
+// Chama f(entrada) para cada ponto das células que tocam o quadrado de lado
+// 2 * raio centrado em c; quem chama testa a distância
+template <class G, class F>
+void gradeVisitarJanela(const G &g, Coord c, long long raio, F testar) {
+    JanelaGrade j = gradeJanela(g, c, raio);
+    long long celulas = j.celulas();
+    if (celulas == 0) return;
+    // Janela maior que o número de células ocupadas: percorre só as ocupadas
+    if (celulas > (long long)gradeQtdCelulas(g)) {
+        gradeVisitarTodas(g, testar);
+    } else {
+        for (long long cx = j.x0; cx <= j.x1; cx++)
+            for (long long cy = j.y0; cy <= j.y1; cy++)
+                gradeVisitarCelula(g, (int)cx, (int)cy, testar);
+    }
+}
+
+// Uma célula custa uma busca na tabela de hashing; o kernel filtra dezenas
+// de pontos no mesmo tempo. Acima disto, a varredura completa compensa.
+const int PONTOS_POR_CELULA_VARREDURA = 64;
+
+inline bool gradeVarrerTudo(const GradeEspacial &g, Coord c, int raio) {
+    long long celulas = gradeJanela(g, c, raio).celulas();
+    return celulas > 0 && celulas > (long long)(g.total / PONTOS_POR_CELULA_VARREDURA);
+}
+
+// Passa os pontos [ini, fim) dos arrays da grade pelo kernel e acrescenta os
+// aceitos a res, sem ordenar
+inline void gradeVarrerRaio(const GradeEspacial &g, size_t ini, size_t fim, Coord c, int raio,
+                            vector<Vizinho> &res) {
+    static thread_local vector<uint32_t> buffer;
+    vector<uint32_t> &aceitos = buffer;
+    // As versões vetoriais gravam blocos inteiros: folga de 8 no fim
+    if (aceitos.size() < fim - ini + 8) aceitos.resize(fim - ini + 8);
+    size_t k = kernelDistancia.raio(g.x.data() + ini, g.y.data() + ini, fim - ini, c, raio,
+                                    (uint32_t)ini, aceitos.data());
+    for (size_t j = 0; j < k; j++) {
+        uint32_t i = aceitos[j];
+        res.push_back({dist2(c, g.x[i], g.y[i]), g.id[i]});
+    }
+}
+
+// Acrescenta a res os pontos a até 'raio' de c, sem ordenar: célula por
+// célula quando a janela é pequena, ou varrendo todos os pontos
+template <class G>
+void gradeColetarRaio(const G &g, Coord c, int raio, vector<Vizinho> &res, uint64_t &pontos) {
+    if constexpr (is_same_v<G, GradeEspacial>) {
+        if (gradeVarrerTudo(g, c, raio)) {
+            pontos += g.total;
+            gradeVarrerRaio(g, 0, g.total, c, raio, res);
+            return;
+        }
+    }
+    long long r2 = (long long)raio * raio;
+    gradeVisitarJanela(g, c, raio, [&](const EntradaGrade &e) {
+        pontos++;
+        long long d2 = dist2(c, e.x, e.y);
+        if (d2 <= r2) res.push_back({d2, e.id});
+    });
+}
+
+// Todos os profissionais a até 'raio' de c, ordenados pela distância
+template <class G>
+vector<Vizinho> gradeRaio(const G &g, Coord c, int raio) {
+    Cronometro cron(MET_RAIO);
+    vector<Vizinho> res;
+    uint64_t pontos = 0;
+    gradeColetarRaio(g, c, raio, res, pontos);
+    sort(res.begin(), res.end());
+    metricaRegistrar(MET_PROXIMIDADE_PONTOS, pontos);
+    return res;
+}
+
+// Os k profissionais mais próximos de c aceitos pelo filtro, do mais perto ao
+// mais longe. Percorre anéis de células ao redor de c e para quando nenhuma
+// célula ainda não visitada pode conter alguém mais perto que o k-ésimo
+// encontrado.
+template <class G, class F>
+vector<Vizinho> gradeKMelhores(const G &g, Coord c, int k, F aceita) {
+    // Heap de máximo com os k atuais, num vetor reaproveitado pela thread
+    static thread_local vector<Vizinho> melhores;
+    melhores.clear();
+    uint64_t pontos = 0;
+    auto testar = [&](const EntradaGrade &e) {
+        pontos++;
+        if (!aceita(e)) return;
+        long long d2 = dist2(c, e.x, e.y);
+        if ((int)melhores.size() < k) {
+            melhores.push_back({d2, e.id});
+            push_heap(melhores.begin(), melhores.end());
+        } else if (d2 < melhores.front().first) {
+            pop_heap(melhores.begin(), melhores.end());
+            melhores.back() = {d2, e.id};
+            push_heap(melhores.begin(), melhores.end());
+        }
+    };
+
+    if (k > 0 && g.total > 0) {
+        int cx0 = celulaDe(c.x, g.lado), cy0 = celulaDe(c.y, g.lado);
+        // Anéis anteriores a r0 não tocam a extensão ocupada
+        long long r0 = max(max(0LL, max((long long)g.minCx - cx0, (long long)cx0 - g.maxCx)),
+                           max((long long)g.minCy - cy0, (long long)cy0 - g.maxCy));
+        size_t visitadas = 0;
+        for (long long r = r0;; r++) {
+            long long x0 = (long long)cx0 - r, x1 = (long long)cx0 + r;
+            long long y0 = (long long)cy0 - r, y1 = (long long)cy0 + r;
+            long long ya = max(y0, (long long)g.minCy), yb = min(y1, (long long)g.maxCy);
+            for (long long cx = max(x0, (long long)g.minCx); cx <= min(x1, (long long)g.maxCx); cx++) {
+                if (cx == x0 || cx == x1) {
+                    for (long long cy = ya; cy <= yb; cy++)
+                        gradeVisitarCelula(g, (int)cx, (int)cy, testar);
+                    visitadas += max(0LL, yb - ya + 1);
+                } else {
+                    if (y0 >= g.minCy) gradeVisitarCelula(g, (int)cx, (int)y0, testar);
+                    if (y1 <= g.maxCy && y1 != y0) gradeVisitarCelula(g, (int)cx, (int)y1, testar);
+                    visitadas += 2;
+                }
+            }
+
+            // Anéis cobriram toda a extensão ocupada
+            if (x0 <= g.minCx && x1 >= g.maxCx && y0 <= g.minCy && y1 >= g.maxCy) break;
+
+            // Menor distância possível até uma célula fora dos anéis visitados
+            long long folga = min(min((long long)c.x - x0 * g.lado, (x1 + 1) * g.lado - c.x),
+                                  min((long long)c.y - y0 * g.lado, (y1 + 1) * g.lado - c.y));
+            if ((int)melhores.size() == k && quadradoSaturado(folga) >= melhores.front().first) break;
+
+            // Região muito esparsa: varrer as células ocupadas sai mais barato
+            if (visitadas > 2 * gradeQtdCelulas(g)) {
+                melhores.clear();
+                gradeVisitarTodas(g, testar);
+                break;
+            }
+        }
+    }
+
+    sort_heap(melhores.begin(), melhores.end());
+    metricaRegistrar(MET_PROXIMIDADE_PONTOS, pontos);
+    return vector<Vizinho>(melhores.begin(), melhores.end());
+}
+
+template <class G>
+vector<Vizinho> gradeKProximos(const G &g, Coord c, int k) {
+    Cronometro cron(MET_KPROXIMOS);
+    return gradeKMelhores(g, c, k, [](const EntradaGrade &) { return true; });
+}
+
+inline size_t bytesGrade(const GradeEspacial &g) {
+    size_t bytes = g.celulas.bucket_count() * sizeof(void*);
+    for (const auto &cel : g.celulas)
+        bytes += sizeof cel + 2 * sizeof(void*) + cel.second.capacity() * sizeof(EntradaGrade);
+    bytes += (g.x.capacity() + g.y.capacity()) * sizeof(int32_t) + g.id.capacity() * sizeof(IdProf);
+    return bytes;
+}
+
+/* ===========================
+        ESPECIALIDADES
+=========================== */
+// Uma lista de IDs por especialidade, em ordem de cadastro: listar uma
+// especialidade é uma varredura sequencial e a contagem é O(1). Cada
+// especialidade tem também a sua grade espacial, para que "os k pediatras
+// mais próximos" só visite pediatras. Com ~1/8 dos pontos, essas grades usam
+// células de lado ~sqrt(8) vezes maior: a ocupação média por célula fica a
+// da grade geral e a busca visita o mesmo número de células.
+const int TAM_CELULA_ESP = 3 * TAM_CELULA;
+
+struct IndiceEspecialidade {
+    vector<IdProf> lista[QTD_ESPECIALIDADES];
+    GradeEspacial grade[QTD_ESPECIALIDADES];
+
+    IndiceEspecialidade() {
+        for (GradeEspacial &g : grade) g.lado = TAM_CELULA_ESP;
+    }
+};
+
+inline IndiceEspecialidade indiceEsp;
+
+inline void espInserir(IndiceEspecialidade &ie, IdEsp esp, IdProf id) {
+    ie.lista[esp].push_back(id);
+    gradeInserir(ie.grade[esp], prof(id).pos, id);
+}
+
+inline size_t espContar(const IndiceEspecialidade &ie, IdEsp esp) {
+    return ie.lista[esp].size();
+}
+
+inline vector<Vizinho> espKProximos(const IndiceEspecialidade &ie, IdEsp esp, Coord c, int k) {
+    Cronometro cron(MET_KPROXIMOS_ESP);
+    return gradeKMelhores(ie.grade[esp], c, k, [](const EntradaGrade &) { return true; });
+}
+
+// As listas estão em ordem de ID (cadastro), então o cursor é o último ID
+// visto e a página começa por busca binária. SEM_ID = início.
+inline vector<IdProf> paginaEspecialidade(const IndiceEspecialidade &ie, IdEsp esp,
+                                   IdProf apos, size_t n) {
+    Cronometro cron(MET_PAGINA);
+    const vector<IdProf> &l = ie.lista[esp];
+    auto it = apos == SEM_ID ? l.begin() : upper_bound(l.begin(), l.end(), apos);
+    size_t qtd = min(n, (size_t)(l.end() - it));
+    return vector<IdProf>(it, it + qtd);
+}
+
+/* ===========================
+        LISTAGENS
+=========================== */
+inline void imprimirProfissional(SaidaBuffer &out, IdProf id) {
+    const Profissional &p = prof(id);
+    out << "| Nome: " << p.nome << '\n'
+        << "| Especialidade: " << ESPECIALIDADES[p.especialidade] << '\n'
+        << "| CRM: " << p.crm << '\n'
+        << "| Coordenadas: (" << p.pos.x << ", " << p.pos.y << ")\n\n";
+}
+
+inline void listarPorNome(const ArvoreB &a) {
+    Cronometro cron(MET_LISTAR_NOME);
+    SaidaBuffer out;
+    arvorePercorrer(a, [&](IdProf id) { imprimirProfissional(out, id); });
+}
+
+inline void imprimirPorEspecialidade(SaidaBuffer &out, IdProf id) {
+    const Profissional &p = prof(id);
+    out << "| Especialidade: " << ESPECIALIDADES[p.especialidade] << '\n'
+        << "| Nome: " << p.nome << '\n'
+        << "| CRM: " << p.crm << '\n'
+        << "| Coordenadas: (" << p.pos.x << ", " << p.pos.y << ")\n\n";
+}
+
+inline void listarEspecialidade(const IndiceEspecialidade &ie, IdEsp esp) {
+    Cronometro cron(MET_LISTAR_ESP);
+    SaidaBuffer out;
+    for (IdProf id : ie.lista[esp]) imprimirPorEspecialidade(out, id);
+}
+
+// Todas as especialidades, em ordem alfabética
+inline void listarPorEspecialidade(const IndiceEspecialidade &ie) {
+    IdEsp ordem[QTD_ESPECIALIDADES];
+    for (int i = 0; i < QTD_ESPECIALIDADES; i++) ordem[i] = (IdEsp)i;
+    sort(ordem, ordem + QTD_ESPECIALIDADES, [](IdEsp a, IdEsp b) {
+        return string_view(ESPECIALIDADES[a]) < string_view(ESPECIALIDADES[b]);
+    });
+    for (IdEsp esp : ordem) listarEspecialidade(ie, esp);
+}
+
+/* ===========================
+        CADASTROS
+=========================== */
+// Retorna o ID da nova cidade, ou -1 se ela não cabe (veja cidadeCabe)
+inline int cidadeInserir(string_view nome, bool temHospital, Coord pos = SEM_POSICAO) {
+    Cronometro cron(MET_CADASTRO_CIDADE);
+    if (!cidadeCabe(nome)) return -1;
+    qtdCidades++;
+    cidades.texto.append(nome);
+    cidades.inicio.push_back((uint32_t)cidades.texto.size());
+    cidades.pos.push_back(pos);
+    bitsetDefinir(hospital, qtdCidades, temHospital);
+    cidadeIndexar(cidades, qtdCidades);
+    grafoAdicionarVertice(grafo);
+    grafoAdicionarVertice(grafoReverso);
+    tabelaNovaCidade(tabelaHosp, qtdCidades);
+    alcanceNovaCidade(alcance, qtdCidades);
+    indiceCH.pronto = false;
+    return qtdCidades;
+}
+
+inline void viaInserir(int o, int d, int t) {
+    Cronometro cron(MET_CADASTRO_VIA);
+    // Orientado (mão única). Para mão dupla, adicione também (d, o).
+    if (grafoAdicionarAresta(grafo, o, d, t)) {
+        grafoAdicionarAresta(grafoReverso, d, o, t);
+        tabelaNovaVia(tabelaHosp, o, d, t);
+        alcanceNovaVia(alcance, o, d);
+        cacheHospitaisNovaVia(cacheHospitais, o);
+        indiceCH.pronto = false;
+    }
+}
+
+// Um único registro; índices e grade guardam só o ID
+inline IdProf profissionalInserir(string_view nome, IdEsp esp, int crm, Coord pos) {
+    Cronometro cron(MET_CADASTRO_PROF);
+    IdProf id = cadastroInserir(cadastro, nome, esp, crm, pos);
+    arvoreInserir(arvoreNome, prof(id).nome, id);
+    nomesNormalizadosInserir(nomesNormalizados, id);
+    espInserir(indiceEsp, esp, id);
+    crmInserir(indiceCRM, crm, id);
+    gradeInserir(grade, pos, id);
+    return id;
+}
+
+/* ===========================
+   LOG DE ESCRITA (WAL)
+=========================== */
+// Cada cadastro vira um registro binário compacto anexado ao log antes de ser
+// aplicado. Um thread escritor junta os registros pendentes e faz um único
+// write + fsync por lote (group commit). Modos de fsync:
+//   sempre - o cadastro só é confirmado depois do fsync do seu lote
+//   grupo  - confirma na hora; o lote é sincronizado em até INTERVALO_GRUPO
+//   nunca  - só write(); o sistema operacional decide quando gravar
+// Cada registro leva um número de sequência (LSN). O snapshot guarda o último
+// LSN aplicado, e a recuperação reaplica apenas os registros posteriores.
+// Se um write ou fsync falha, o log fica em estado de falha: nada mais é
+// anexado nem confirmado, e os cadastros passam a ser recusados.
+//
+// Os registros guardam IDs de cidades por posição, então só valem sobre o
+// estado em que o log começou. O arquivo abre com um cabeçalho que identifica
+// esse estado (a base): um ID do log, o LSN e uma impressão (contagens e
+// CRC dos nomes de cidades). Na partida o log só é reaplicado sobre a própria
+// base ou sobre um snapshot gravado com ele (que leva o mesmo ID); qualquer
+// outro estado, como o de uma importação, é recusado.
+//
+// Cabeçalho: BaseLog. Registro: [u32 tamanho do corpo][u32 crc32][u64 lsn][u8 tipo][corpo]
+enum TipoRegistroLog : uint8_t { LOG_CIDADE = 1, LOG_VIA = 2, LOG_PROFISSIONAL = 3 };
+enum ModoFsync { FSYNC_SEMPRE, FSYNC_GRUPO, FSYNC_NUNCA };
+
+const auto INTERVALO_GRUPO = chrono::milliseconds(5);
+const size_t LIMITE_LOTE = 1 << 20; // acorda o escritor antes do prazo
+
+struct LogEscrita {
+    bool ativo = false;
+    int fd = -1;
+    ModoFsync modo = FSYNC_GRUPO;
+    mutex m;
+    condition_variable temTrabalho, gravou;
+    vector<char> pendente;
+    uint64_t lsnPendente = 0;  // último LSN colocado no buffer
+    uint64_t lsnDuravel = 0;   // último LSN já gravado (e sincronizado)
+    bool parar = false;
+    bool falhou = false;       // write ou fsync falhou: lsnDuravel não avança mais
+    bool adiarConfirmacao = false; // modo sempre: quem anexa chama logAguardarDuravel
+    thread escritor;
+};
+
+inline LogEscrita wal;
+inline uint64_t lsnAtual = 0; // último registro aplicado ao estado
+// Log do qual vieram os registros até lsnAtual (0 = nenhum, ou o estado
+// mudou fora de um log: importação ou cadastro sem --wal)
+inline uint64_t idLogEstado = 0;
+
+const char MAGICA_LOG[8] = {'S', 'S', 'A', 'U', 'D', 'E', 'W', 'L'};
+
+struct BaseLog {
+    char magica[8];
+    uint32_t versao;
+    uint32_t crc;                // dos campos seguintes
+    uint64_t id, lsn;
+    int32_t qtdCidades;
+    uint32_t crcNomesCidades;
+    uint64_t qtdVias, qtdProfs;
+};
+
+inline void garantirMaterializado(); // carrega o snapshot mapeado, se houver
+
+inline uint32_t crc32(const char *dados, size_t n, uint32_t crc = 0) {
+    // Inicialização de static local é segura entre threads
+    struct Tabela {
+        uint32_t v[256];
+        Tabela() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                v[i] = c;
+            }
+        }
+    };
+    static const Tabela t;
+    const uint32_t *tabela = t.v;
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++) crc = tabela[(crc ^ (uint8_t)dados[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+template <class T>
+void logPor(vector<char> &b, T v) {
+    const char *p = (const char*)&v;
+    b.insert(b.end(), p, p + sizeof v);
+}
+
+inline void logPorTexto(vector<char> &b, string_view s) {
+    logPor<uint32_t>(b, (uint32_t)s.size());
+    b.insert(b.end(), s.begin(), s.end());
+}
+
+inline void logEscritor(LogEscrita &w) {
+    vector<char> lote;
+    unique_lock<mutex> trava(w.m);
+    for (;;) {
+        w.temTrabalho.wait(trava, [&] { return w.parar || !w.pendente.empty(); });
+        if (w.pendente.empty() && w.parar) return;
+        // No modo grupo espera o prazo para juntar mais registros no lote
+        if (w.modo != FSYNC_SEMPRE && !w.parar)
+            w.temTrabalho.wait_for(trava, INTERVALO_GRUPO,
+                                   [&] { return w.parar || w.pendente.size() >= LIMITE_LOTE; });
+
+        lote.swap(w.pendente);
+        uint64_t lsn = w.lsnPendente;
+        trava.unlock();
+
+        bool ok = true;
+        for (size_t feito = 0; feito < lote.size();) {
+            ssize_t r = write(w.fd, lote.data() + feito, lote.size() - feito);
+            if (r < 0) {
+                if (errno == EINTR) continue;
+                cerr << "WAL: falha de escrita (" << strerror(errno) << ")\n";
+                ok = false;
+                break;
+            }
+            feito += r;
+        }
+        if (ok && w.modo != FSYNC_NUNCA && fdatasync(w.fd) != 0) {
+            cerr << "WAL: falha no fsync (" << strerror(errno) << ")\n";
+            ok = false;
+        }
+        lote.clear();
+
+        trava.lock();
+        if (!ok) {
+            // Não se sabe o que chegou ao disco: nada deste lote é confirmado
+            w.falhou = true;
+            w.pendente.clear();
+            w.gravou.notify_all();
+            return;
+        }
+        w.lsnDuravel = lsn;
+        w.gravou.notify_all();
+    }
+}
+
+inline bool logFalhou() {
+    if (!wal.ativo) return false;
+    lock_guard<mutex> trava(wal.m);
+    return wal.falhou;
+}
+
+// Coloca o registro no buffer; no modo 'sempre', espera o fsync do lote.
+// Retorna false se o log está (ou ficou, antes do fsync) em falha: o
+// cadastro não deve ser aplicado nem confirmado.
+inline bool logAnexar(TipoRegistroLog tipo, const vector<char> &corpo) {
+    if (!wal.ativo) {
+        lsnAtual++;
+        idLogEstado = 0;
+        return true;
+    }
+    if (logFalhou()) return false;
+    Cronometro cron(MET_WAL_ANEXAR);
+    lsnAtual++;
+
+    vector<char> cab;
+    logPor<uint32_t>(cab, (uint32_t)corpo.size());
+    logPor<uint32_t>(cab, 0); // crc, preenchido abaixo
+    logPor<uint64_t>(cab, lsnAtual);
+    logPor<uint8_t>(cab, tipo);
+    uint32_t crc = crc32(cab.data() + 8, cab.size() - 8);
+    crc = crc32(corpo.data(), corpo.size(), crc);
+    memcpy(cab.data() + 4, &crc, 4);
+
+    unique_lock<mutex> trava(wal.m);
+    wal.pendente.insert(wal.pendente.end(), cab.begin(), cab.end());
+    wal.pendente.insert(wal.pendente.end(), corpo.begin(), corpo.end());
+    wal.lsnPendente = lsnAtual;
+    wal.temTrabalho.notify_one();
+    if (wal.modo == FSYNC_SEMPRE && !wal.adiarConfirmacao) {
+        uint64_t meu = lsnAtual;
+        wal.gravou.wait(trava, [&] { return wal.lsnDuravel >= meu || wal.falhou; });
+        if (wal.lsnDuravel < meu) {
+            lsnAtual--; // não será aplicado
+            return false;
+        }
+    }
+    return true;
+}
+
+// A coordenada vai no fim e só quando existe: registros antigos continuam
+// válidos
+inline bool logCidade(const string &nome, bool temHospital, Coord pos = SEM_POSICAO) {
+    vector<char> b;
+    logPor<uint8_t>(b, temHospital);
+    logPorTexto(b, nome);
+    if (temPosicao(pos)) {
+        logPor<int32_t>(b, pos.x);
+        logPor<int32_t>(b, pos.y);
+    }
+    return logAnexar(LOG_CIDADE, b);
+}
+
+inline bool logVia(int o, int d, int t) {
+    vector<char> b;
+    logPor<int32_t>(b, o);
+    logPor<int32_t>(b, d);
+    logPor<int32_t>(b, t);
+    return logAnexar(LOG_VIA, b);
+}
+
+inline bool logProfissional(string_view nome, IdEsp esp, int crm, Coord pos) {
+    vector<char> b;
+    logPor<uint8_t>(b, esp);
+    logPor<int32_t>(b, crm);
+    logPor<int32_t>(b, pos.x);
+    logPor<int32_t>(b, pos.y);
+    logPorTexto(b, nome);
+    return logAnexar(LOG_PROFISSIONAL, b);
+}
+
+struct LeitorRegistro {
+    const char *p, *fim;
+    bool ok = true;
+
+    template <class T>
+    T ler() {
+        T v{};
+        if (fim - p < (ptrdiff_t)sizeof v) { ok = false; return v; }
+        memcpy(&v, p, sizeof v);
+        p += sizeof v;
+        return v;
+    }
+    string_view texto() {
+        uint32_t n = ler<uint32_t>();
+        if (!ok || (size_t)(fim - p) < n) { ok = false; return {}; }
+        string_view s(p, n);
+        p += n;
+        return s;
+    }
+};
+
+// Aplica um registro do log; false se o conteúdo for inválido
+inline bool logAplicar(uint8_t tipo, LeitorRegistro &r) {
+    switch (tipo) {
+        case LOG_CIDADE: {
+            bool h = r.ler<uint8_t>();
+            string_view nome = r.texto();
+            Coord pos = SEM_POSICAO;
+            if (r.ok && r.p < r.fim) {
+                pos.x = r.ler<int32_t>();
+                pos.y = r.ler<int32_t>();
+            }
+            return r.ok && cidadeInserir(string(nome), h, pos) != -1;
+        }
+        case LOG_VIA: {
+            int o = r.ler<int32_t>(), d = r.ler<int32_t>(), t = r.ler<int32_t>();
+            if (!r.ok || o < 1 || d < 1 || o > qtdCidades || d > qtdCidades || t < 1) return false;
+            viaInserir(o, d, t);
+            return true;
+        }
+        case LOG_PROFISSIONAL: {
+            IdEsp esp = r.ler<uint8_t>();
+            Coord pos;
+            int crm = r.ler<int32_t>();
+            pos.x = r.ler<int32_t>();
+            pos.y = r.ler<int32_t>();
+            string_view nome = r.texto();
+            if (!r.ok || esp >= QTD_ESPECIALIDADES || crmExiste(crm) ||
+                arvoreBuscar(arvoreNome, nome) != SEM_ID)
+                return false;
+            profissionalInserir(nome, esp, crm, pos);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Base de um log novo: o estado atual (materializado)
+inline BaseLog logBaseAtual(uint64_t id) {
+    BaseLog b;
+    memset(&b, 0, sizeof b);
+    memcpy(b.magica, MAGICA_LOG, sizeof MAGICA_LOG);
+    b.versao = 1;
+    b.id = id;
+    b.lsn = lsnAtual;
+    b.qtdCidades = qtdCidades;
+    b.crcNomesCidades = crc32(cidades.texto.data(), cidades.texto.size());
+    b.qtdVias = grafo.destino.size() + grafo.bufDestino.size();
+    b.qtdProfs = cadastro.registros.size();
+    b.crc = crc32((const char*)&b.id, sizeof b - offsetof(BaseLog, id));
+    return b;
+}
+
+// Se os registros do log com base b podem ser reaplicados sobre o estado atual
+inline bool logBaseConfere(const BaseLog &b) {
+    if (idLogEstado == b.id) return lsnAtual >= b.lsn;
+    if (lsnAtual != b.lsn) return false;
+    garantirMaterializado();
+    BaseLog atual = logBaseAtual(b.id);
+    return atual.qtdCidades == b.qtdCidades && atual.crcNomesCidades == b.crcNomesCidades &&
+           atual.qtdVias == b.qtdVias && atual.qtdProfs == b.qtdProfs;
+}
+
+// Reaplica o log sobre o estado atual (snapshot + importações), se ele for a
+// base do log ou um snapshot gravado com ele, e o abre para novos registros.
+// Um final truncado ou corrompido (queda no meio de uma escrita) é
+// descartado. Um arquivo vazio recebe o cabeçalho com o estado atual como
+// base; um log de versão anterior, sem cabeçalho, é reaplicado sem conferir.
+inline bool logAbrir(const char *caminho, ModoFsync modo) {
+    int fd = open(caminho, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        cerr << "Nao foi possivel abrir o log " << caminho << "\n";
+        return false;
+    }
+
+    vector<char> dados;
+    char bloco[1 << 16];
+    for (ssize_t r; (r = read(fd, bloco, sizeof bloco)) > 0;)
+        dados.insert(dados.end(), bloco, bloco + r);
+
+    size_t pos = 0;
+    uint64_t id = 0;
+    if (dados.size() >= sizeof MAGICA_LOG && memcmp(dados.data(), MAGICA_LOG, sizeof MAGICA_LOG) == 0) {
+        BaseLog b;
+        if (dados.size() < sizeof b) {
+            cerr << "WAL: cabecalho truncado em " << caminho << "\n";
+            close(fd);
+            return false;
+        }
+        memcpy(&b, dados.data(), sizeof b);
+        if (b.versao != 1 || crc32((const char*)&b.id, sizeof b - offsetof(BaseLog, id)) != b.crc) {
+            cerr << "WAL: cabecalho invalido em " << caminho << "\n";
+            close(fd);
+            return false;
+        }
+        if (!logBaseConfere(b)) {
+            cerr << "WAL: " << caminho << " foi iniciado sobre outro estado (snapshot ou importacao"
+                 << " diferente); abra o snapshot gravado com este log ou use um log novo.\n";
+            close(fd);
+            return false;
+        }
+        id = b.id;
+        pos = sizeof b;
+    } else if (dados.empty()) {
+        garantirMaterializado();
+        id = (uint64_t)chrono::system_clock::now().time_since_epoch().count() ^ ((uint64_t)getpid() << 40);
+        id |= 1; // nunca 0
+        BaseLog b = logBaseAtual(id);
+        if (write(fd, &b, sizeof b) != (ssize_t)sizeof b || fdatasync(fd) != 0) {
+            cerr << "WAL: nao foi possivel gravar o cabecalho em " << caminho << "\n";
+            close(fd);
+            return false;
+        }
+        dados.assign((const char*)&b, (const char*)&b + sizeof b);
+        pos = sizeof b;
+    }
+
+    const size_t CAB = 4 + 4 + 8 + 1;
+    long aplicados = 0;
+    while (dados.size() - pos >= CAB) {
+        uint32_t tam, crc;
+        uint64_t lsn;
+        memcpy(&tam, &dados[pos], 4);
+        memcpy(&crc, &dados[pos + 4], 4);
+        memcpy(&lsn, &dados[pos + 8], 8);
+        uint8_t tipo = dados[pos + 16];
+        if (dados.size() - pos - CAB < tam) break;
+        uint32_t conf = crc32(&dados[pos + 8], 9);
+        if (crc32(&dados[pos + CAB], tam, conf) != crc) break;
+
+        if (lsn > lsnAtual) {
+            // Lacuna: o log é posterior ao estado carregado
+            if (lsn != lsnAtual + 1) {
+                cerr << "WAL: registro " << lsn << " nao segue o estado atual (" << lsnAtual
+                     << "); use o snapshot correspondente.\n";
+                close(fd);
+                return false;
+            }
+            garantirMaterializado();
+            LeitorRegistro r{&dados[pos + CAB], &dados[pos + CAB] + tam};
+            if (!logAplicar(tipo, r)) {
+                cerr << "WAL: registro " << lsn << " invalido.\n";
+                close(fd);
+                return false;
+            }
+            lsnAtual = lsn;
+            aplicados++;
+        }
+        pos += CAB + tam;
+    }
+    if (pos < dados.size()) {
+        cerr << "WAL: descartando " << dados.size() - pos << " bytes incompletos no final.\n";
+        if (ftruncate(fd, pos) != 0) {
+            close(fd);
+            return false;
+        }
+    }
+    lseek(fd, 0, SEEK_END);
+    if (aplicados) cout << "WAL: " << aplicados << " registros recuperados.\n";
+
+    idLogEstado = id;
+    wal.fd = fd;
+    wal.modo = modo;
+    wal.lsnDuravel = wal.lsnPendente = lsnAtual;
+    wal.ativo = true;
+    wal.escritor = thread(logEscritor, ref(wal));
+    return true;
+}
+
+// Espera o fsync de tudo o que já foi anexado (vários cadastros, um lote);
+// false se o log falhou antes disso
+inline bool logAguardarDuravel() {
+    if (!wal.ativo) return true;
+    unique_lock<mutex> trava(wal.m);
+    uint64_t alvo = wal.lsnPendente;
+    wal.gravou.wait(trava, [&] { return wal.lsnDuravel >= alvo || wal.falhou; });
+    return wal.lsnDuravel >= alvo;
+}
+
+// Grava o que estiver pendente e encerra o escritor
+inline void logFechar() {
+    if (!wal.ativo) return;
+    {
+        lock_guard<mutex> trava(wal.m);
+        wal.parar = true;
+    }
+    wal.temTrabalho.notify_one();
+    wal.escritor.join();
+    close(wal.fd);
+    wal.ativo = false;
+}
+
+/* ===========================
+   IMPORTAÇÃO EM LOTE (CSV)
+=========================== */
+// Formatos (uma linha por registro, linhas iniciadas por '#' são ignoradas):
+//   cidades:        nome,hospital            (hospital = 1 ou 0)
+//   vias:           origem,destino,tempo     (IDs das cidades, tempo em min)
+//   profissionais:  nome,especialidade,crm,x,y
+// O arquivo é lido em blocos grandes e as linhas são quebradas no próprio
+// buffer, sem cópias. Vias e nomes são ordenados uma vez e os índices são
+// montados de baixo para cima, em vez de n inserções.
+const size_t TAM_LEITURA = 1 << 20;
+
+struct LeitorCSV {
+    FILE *arq = NULL;
+    vector<char> buf;
+    size_t pos = 0, fim = 0;
+    bool eof = false;
+    long linha = 0;
+};
+
+inline bool leitorAbrir(LeitorCSV &l, const char *caminho) {
+    l.arq = fopen(caminho, "rb");
+    l.buf.resize(TAM_LEITURA);
+    return l.arq != NULL;
+}
+
+inline void leitorFechar(LeitorCSV &l) {
+    if (l.arq) fclose(l.arq);
+    l.arq = NULL;
+}
+
+// Preenche 'campos' com a próxima linha não vazia. Os string_view apontam
+// para o buffer e valem até a próxima chamada.
+inline bool leitorProximaLinha(LeitorCSV &l, vector<string_view> &campos) {
+    for (;;) {
+        char *ini = l.buf.data() + l.pos;
+        char *nl = (char*)memchr(ini, '\n', l.fim - l.pos);
+        if (!nl && !l.eof) {
+            // Linha incompleta: move o resto para o início e lê mais
+            size_t resto = l.fim - l.pos;
+            if (resto == l.buf.size()) l.buf.resize(l.buf.size() * 2);
+            memmove(l.buf.data(), ini, resto);
+            l.pos = 0;
+            l.fim = resto + fread(l.buf.data() + resto, 1, l.buf.size() - resto, l.arq);
+            if (l.fim == resto) l.eof = true;
+            continue;
+        }
+        if (!nl && l.pos == l.fim) return false;
+
+        char *fimLinha = nl ? nl : l.buf.data() + l.fim;
+        l.pos = nl ? (size_t)(nl - l.buf.data()) + 1 : l.fim;
+        l.linha++;
+        if (fimLinha > ini && fimLinha[-1] == '\r') fimLinha--;
+        if (fimLinha == ini || *ini == '#') continue;
+
+        campos.clear();
+        for (char *c = ini;;) {
+            char *virg = (char*)memchr(c, ',', fimLinha - c);
+            if (!virg) {
+                campos.emplace_back(c, fimLinha - c);
+                break;
+            }
+            campos.emplace_back(c, virg - c);
+            c = virg + 1;
+        }
+        return true;
+    }
+}
+
+inline bool lerInt(string_view s, int &v) {
+    while (!s.empty() && s.front() == ' ') s.remove_prefix(1);
+    while (!s.empty() && s.back() == ' ') s.remove_suffix(1);
+    auto r = from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == errc() && r.ptr == s.data() + s.size();
+}
+
+// Aceita o nome da especialidade ou seu número (1..QTD_ESPECIALIDADES)
+inline bool lerEspecialidade(string_view s, IdEsp &esp) {
+    int n;
+    if (lerInt(s, n)) {
+        if (n < 1 || n > QTD_ESPECIALIDADES) return false;
+        esp = (IdEsp)(n - 1);
+        return true;
+    }
+    for (int i = 0; i < QTD_ESPECIALIDADES; i++) {
+        if (s == ESPECIALIDADES[i]) {
+            esp = (IdEsp)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct ResumoImportacao {
+    long aceitos = 0, rejeitados = 0;
+};
+
+inline void avisoLinha(const char *arquivo, const LeitorCSV &l, const char *motivo) {
+    cerr << arquivo << ":" << l.linha << ": " << motivo << "\n";
+}
+
+inline ResumoImportacao importarCidades(const char *caminho) {
+    ResumoImportacao r;
+    LeitorCSV l;
+    if (!leitorAbrir(l, caminho)) {
+        cerr << "Nao foi possivel abrir " << caminho << "\n";
+        return r;
+    }
+    vector<string_view> campos;
+    while (leitorProximaLinha(l, campos)) {
+        int h;
+        Coord pos = SEM_POSICAO;
+        if ((campos.size() != 2 && campos.size() != 4) || !lerInt(campos[1], h) ||
+            (campos.size() == 4 && (!lerInt(campos[2], pos.x) || !lerInt(campos[3], pos.y)))) {
+            avisoLinha(caminho, l, "linha invalida");
+            r.rejeitados++;
+        } else if (cidadeInserir(campos[0], h == 1, pos) == -1) {
+            avisoLinha(caminho, l, "limite de cidades atingido");
+            r.rejeitados++;
+            break;
+        } else {
+            r.aceitos++;
+        }
+    }
+    leitorFechar(l);
+    return r;
+}
+
+inline ResumoImportacao importarVias(const char *caminho) {
+    ResumoImportacao r;
+    LeitorCSV l;
+    if (!leitorAbrir(l, caminho)) {
+        cerr << "Nao foi possivel abrir " << caminho << "\n";
+        return r;
+    }
+
+    // Vias já cadastradas + novas, e o CSR é remontado uma única vez
+    vector<Aresta> arestas;
+    for (int v = 1; v <= grafo.n; v++)
+        paraCadaVizinho(grafo, v, [&](int d, int w) { arestas.push_back({v, d, w}); });
+
+    vector<string_view> campos;
+    while (leitorProximaLinha(l, campos)) {
+        int o, d, t;
+        if (campos.size() != 3 || !lerInt(campos[0], o) || !lerInt(campos[1], d) ||
+            !lerInt(campos[2], t) || o < 1 || d < 1 || o > qtdCidades || d > qtdCidades || t < 1) {
+            avisoLinha(caminho, l, "via invalida");
+            r.rejeitados++;
+            continue;
+        }
+        arestas.push_back({o, d, t});
+        r.aceitos++;
+    }
+    leitorFechar(l);
+
+    grafoConstruir(grafo, qtdCidades, arestas);
+    for (Aresta &a : arestas) swap(a.o, a.d);
+    grafoConstruir(grafoReverso, qtdCidades, arestas);
+
+    if (tabelaHosp.ativa) tabelaConstruir(tabelaHosp);
+    alcanceConstruir(alcance);
+    cacheHospitais = CacheHospitais();
+    indiceCH.pronto = false;
+    return r;
+}
+
+inline ResumoImportacao importarProfissionais(const char *caminho) {
+    ResumoImportacao r;
+    LeitorCSV l;
+    if (!leitorAbrir(l, caminho)) {
+        cerr << "Nao foi possivel abrir " << caminho << "\n";
+        return r;
+    }
+
+    vector<pair<string_view, IdProf>> novos;
+    unordered_map<string_view, IdProf> nomesLote;
+    vector<string_view> campos;
+    while (leitorProximaLinha(l, campos)) {
+        IdEsp esp;
+        int crm;
+        Coord pos;
+        if (campos.size() != 5 || campos[0].empty() || !lerEspecialidade(campos[1], esp) ||
+            !lerInt(campos[2], crm) || !lerInt(campos[3], pos.x) || !lerInt(campos[4], pos.y)) {
+            avisoLinha(caminho, l, "profissional invalido");
+            r.rejeitados++;
+            continue;
+        }
+        if (crmExiste(crm)) {
+            avisoLinha(caminho, l, "CRM ja cadastrado");
+            r.rejeitados++;
+            continue;
+        }
+        if (nomesLote.count(campos[0]) || arvoreBuscar(arvoreNome, campos[0]) != SEM_ID) {
+            avisoLinha(caminho, l, "nome ja existe");
+            r.rejeitados++;
+            continue;
+        }
+
+        IdProf id = cadastroInserir(cadastro, campos[0], esp, crm, pos);
+        const Profissional &p = prof(id);
+        nomesLote[p.nome] = id;
+        novos.push_back({p.nome, id});
+        espInserir(indiceEsp, esp, id);
+        crmInserir(indiceCRM, crm, id);
+        gradeInserir(grade, pos, id);
+        r.aceitos++;
+    }
+    leitorFechar(l);
+
+    // Ordena o lote uma vez, intercala com o índice atual e remonta a árvore
+    sort(novos.begin(), novos.end());
+    vector<pair<string_view, IdProf>> todos;
+    todos.reserve(arvoreNome.tamanho + novos.size());
+    arvorePercorrer(arvoreNome, [&](IdProf id) { todos.push_back({prof(id).nome, id}); });
+    size_t meio = todos.size();
+    todos.insert(todos.end(), novos.begin(), novos.end());
+    inplace_merge(todos.begin(), todos.begin() + meio, todos.end());
+    arvoreConstruir(arvoreNome, todos);
+    nomesNormalizadosConstruir(nomesNormalizados);
+    return r;
+}
+
+// Uso: sistema_saude --import cidades.csv vias.csv profissionais.csv
+// ("-" pula um dos arquivos)
+inline void importarLote(const char *cidades, const char *vias, const char *profs) {
+    Cronometro cron(MET_IMPORTACAO);
+    idLogEstado = 0; // fora do log: um log existente só volta a valer sobre a base dele
+    auto relatar = [](const char *tipo, const ResumoImportacao &r) {
+        cout << tipo << ": " << r.aceitos << " importados, " << r.rejeitados << " rejeitados.\n";
+    };
+    if (strcmp(cidades, "-") != 0) relatar("Cidades", importarCidades(cidades));
+    if (strcmp(vias, "-") != 0) relatar("Vias", importarVias(vias));
+    if (strcmp(profs, "-") != 0) relatar("Profissionais", importarProfissionais(profs));
+}
+
+/* ===========================
+   SNAPSHOT BINÁRIO (MMAP)
+=========================== */
+// Arquivo versionado com todo o estado em arrays planos (ordem de bytes da
+// máquina). Na partida ele é mapeado com mmap e as buscas de hospital e de
+// profissionais próximos leem direto do mapeamento, sem desserializar: o
+// tempo de partida não depende do tamanho da base. A primeira operação que
+// precisa das estruturas em memória (cadastro, listagem, troca de modo)
+// carrega o snapshot por cópia de arrays e desfaz o mapeamento.
+const char MAGICA_SNAPSHOT[8] = {'S', 'S', 'A', 'U', 'D', 'E', 'S', 'N'};
+const uint32_t VERSAO_SNAPSHOT = 5;
+
+enum SecaoSnapshot {
+    SEC_HOSPITAL,          // uint8_t[n + 1]
+    SEC_CIDADE_INICIO,     // uint32_t[n + 2], posições em SEC_CIDADE_TEXTO
+    SEC_CIDADE_TEXTO,
+    SEC_CIDADE_POS,        // Coord[n + 1] (SEM_POSICAO = sem coordenada)
+    SEC_GRAFO_INICIO,      // int32_t[n + 2] (CSR)
+    SEC_GRAFO_DESTINO,
+    SEC_GRAFO_PESO,
+    SEC_REVERSO_INICIO,
+    SEC_REVERSO_DESTINO,
+    SEC_REVERSO_PESO,
+    SEC_PROFISSIONAIS,     // RegistroSnapshot[qtdProfs]
+    SEC_PROF_TEXTO,
+    SEC_ORDEM_NOME,        // IdProf[qtdProfs], em ordem alfabética
+    SEC_CRM_CHAVES,        // tabela hash já dimensionada
+    SEC_CRM_VALORES,
+    SEC_ESP_INICIO,        // uint32_t[QTD_ESPECIALIDADES + 1]
+    SEC_ESP_IDS,
+    SEC_GRADE_CHAVES,      // int64_t[qtdCelulas], ordenadas
+    SEC_GRADE_INICIO,      // uint32_t[qtdCelulas + 1]
+    SEC_GRADE_ENTRADAS,    // EntradaGrade[qtdProfs]
+    // Grades por especialidade (lado TAM_CELULA_ESP), uma após a outra
+    SEC_ESP_GRADE_CELULAS, // uint32_t[QTD_ESPECIALIDADES + 1], primeira célula de cada uma
+    SEC_ESP_GRADE_LIMITES, // LimitesGrade[QTD_ESPECIALIDADES]
+    SEC_ESP_GRADE_CHAVES,  // int64_t[qtdCelulas], ordenadas dentro de cada especialidade
+    SEC_ESP_GRADE_INICIO,  // uint32_t[qtdCelulas + QTD_ESPECIALIDADES], relativo à especialidade
+    SEC_ESP_GRADE_ENTRADAS, // EntradaGrade[qtdProfs], na ordem de SEC_ESP_IDS por especialidade
+    QTD_SECOES
+};
+
+struct CabecalhoSnapshot {
+    char magica[8];
+    uint32_t versao;
+    int32_t qtdCidades;
+    uint32_t qtdProfs;
+    int32_t minCx, maxCx, minCy, maxCy;
+    uint32_t pad;
+    uint64_t lsn;                  // último registro do WAL incluído
+    uint64_t idLog;                // log de onde vieram esses registros (0 = nenhum)
+    uint64_t tamanhoArquivo;
+    uint64_t inicio[QTD_SECOES];   // deslocamento de cada seção
+    uint64_t bytes[QTD_SECOES];
+};
+
+struct LimitesGrade {
+    int32_t minCx, maxCx, minCy, maxCy;
+};
+
+struct RegistroSnapshot {
+    uint32_t nomeIni, nomeTam;
+    int32_t crm, x, y;
+    uint8_t especialidade, pad[3];
+};
+
+static_assert(sizeof(int) == 4, "snapshot assume int de 32 bits");
+
+// Visões somente leitura sobre o arquivo mapeado
+struct VisaoCSR {
+    const int *inicio, *destino, *peso;
+};
+
+template <class F>
+void paraCadaVizinho(const VisaoCSR &g, int v, F f) {
+    for (int e = g.inicio[v]; e < g.inicio[v + 1]; e++)
+        f(g.destino[e], g.peso[e]);
+}
+
+struct VisaoGrade {
+    int lado = TAM_CELULA;
+    uint32_t qtdCelulas = 0;
+    const long long *chaves;
+    const uint32_t *inicio;
+    const EntradaGrade *entradas;
+    int minCx = 0, maxCx = -1, minCy = 0, maxCy = -1;
+    size_t total = 0;
+};
+
+inline size_t gradeQtdCelulas(const VisaoGrade &g) {
+    return g.qtdCelulas;
+}
+
+template <class F>
+void gradeVisitarCelula(const VisaoGrade &g, int cx, int cy, F f) {
+    const long long *fim = g.chaves + g.qtdCelulas;
+    const long long *it = lower_bound(g.chaves, fim, chaveCelula(cx, cy));
+    if (it == fim || *it != chaveCelula(cx, cy)) return;
+    size_t c = it - g.chaves;
+    for (uint32_t i = g.inicio[c]; i < g.inicio[c + 1]; i++) f(g.entradas[i]);
+}
+
+template <class F>
+void gradeVisitarTodas(const VisaoGrade &g, F f) {
+    for (size_t i = 0; i < g.total; i++) f(g.entradas[i]);
+}
+
+// Estado completo em arrays planos: aponta para o arquivo mapeado ou para
+// imagens em memória (ImagemMapa / ImagemProfissionais)
+struct Snapshot {
+    bool ativo = false;
+    const char *base = NULL;              // mapeamento; NULL para imagens
+    size_t tamanho = 0;
+    const CabecalhoSnapshot *cab = NULL;
+    int qtdCidades = 0;
+    uint32_t qtdProfs = 0;
+    const uint8_t *hospital;
+    const uint32_t *cidadeInicio;
+    const char *cidadeTexto;
+    const Coord *cidadePos;
+    VisaoCSR grafo, reverso;
+    const RegistroSnapshot *profs;
+    const char *profTexto;
+    const IdProf *ordemNome;
+    const int *crmChaves;
+    const IdProf *crmValores;
+    size_t crmCapacidade = 0;
+    const uint32_t *espInicio;
+    const IdProf *espIds;
+    VisaoGrade grade;
+    VisaoGrade gradeEsp[QTD_ESPECIALIDADES];
+};
+
+inline Snapshot snap;
+
+template <class T>
+const T* secao(const Snapshot &s, SecaoSnapshot sec) {
+    return (const T*)(s.base + s.cab->inicio[sec]);
+}
+
+inline string_view snapNomeCidade(const Snapshot &s, int id) {
+    return string_view(s.cidadeTexto + s.cidadeInicio[id],
+                       s.cidadeInicio[id + 1] - s.cidadeInicio[id]);
+}
+
+inline string_view snapNomeProf(const Snapshot &s, IdProf id) {
+    return string_view(s.profTexto + s.profs[id].nomeIni, s.profs[id].nomeTam);
+}
+
+// Nomes para exibição, venham do mapeamento ou das estruturas em memória
+inline string_view nomeCidadeDe(int id) {
+    return snap.ativo ? snapNomeCidade(snap, id) : cidadeNome(id);
+}
+
+inline int totalCidades() {
+    return snap.ativo ? snap.qtdCidades : qtdCidades;
+}
+
+inline string_view nomeProfDe(IdProf id) {
+    return snap.ativo ? snapNomeProf(snap, id) : prof(id).nome;
+}
+
+inline IdEsp espDe(IdProf id) {
+    return snap.ativo ? snap.profs[id].especialidade : prof(id).especialidade;
+}
+
+// Aponta as grades por especialidade da visão para os arrays achatados
+// (seções SEC_ESP_GRADE_*, no arquivo ou numa imagem)
+inline void visaoGradesEsp(Snapshot &s, const uint32_t *celulas, const LimitesGrade *limites,
+                           const long long *chaves, const uint32_t *inicio, const EntradaGrade *entradas) {
+    for (int i = 0; i < QTD_ESPECIALIDADES; i++) {
+        VisaoGrade &g = s.gradeEsp[i];
+        g.lado = TAM_CELULA_ESP;
+        g.qtdCelulas = celulas[i + 1] - celulas[i];
+        g.chaves = chaves + celulas[i];
+        g.inicio = inicio + celulas[i] + i;
+        g.entradas = entradas + s.espInicio[i];
+        g.minCx = limites[i].minCx; g.maxCx = limites[i].maxCx;
+        g.minCy = limites[i].minCy; g.maxCy = limites[i].maxCy;
+        g.total = s.espInicio[i + 1] - s.espInicio[i];
+    }
+}
+
+// Na grade da própria especialidade, como espKProximos
+inline vector<Vizinho> snapKProximosEsp(const Snapshot &s, IdEsp esp, Coord c, int k) {
+    Cronometro cron(MET_KPROXIMOS_ESP);
+    return gradeKMelhores(s.gradeEsp[esp], c, k, [](const EntradaGrade &) { return true; });
+}
+
+inline vector<Vizinho> kProximosEspecialidade(IdEsp esp, Coord c, int k) {
+    return snap.ativo ? snapKProximosEsp(snap, esp, c, k) : espKProximos(indiceEsp, esp, c, k);
+}
+
+/* --- Imagens em memória --- */
+// O estado atual copiado para arrays planos no layout das seções do arquivo.
+// É o que o snapshot grava e o que o RegistroSaude publica como versão
+// imutável para os leitores. Mapa e profissionais são montados em separado
+// porque mudam independentemente.
+struct ImagemMapa {
+    int qtdCidades = 0;
+    vector<uint8_t> hospital;
+    vector<uint32_t> cidadeInicio;
+    string cidadeTexto;
+    vector<Coord> cidadePos;
+    vector<int> grafoInicio, grafoDestino, grafoPeso;
+    vector<int> reversoInicio, reversoDestino, reversoPeso;
+};
+
+struct ImagemProfissionais {
+    vector<RegistroSnapshot> profs;
+    string profTexto;
+    vector<IdProf> ordemNome;
+    vector<int> crmChaves;
+    vector<IdProf> crmValores;
+    vector<uint32_t> espInicio;
+    vector<IdProf> espIds;
+    vector<long long> gradeChaves;
+    vector<uint32_t> gradeInicio;
+    vector<EntradaGrade> gradeEntradas;
+    int minCx = 0, maxCx = -1, minCy = 0, maxCy = -1;
+    vector<uint32_t> espGradeCelulas;
+    vector<LimitesGrade> espGradeLimites;
+    vector<long long> espGradeChaves;
+    vector<uint32_t> espGradeInicio;
+    vector<EntradaGrade> espGradeEntradas;
+    // Só nas versões publicadas (o arquivo não grava): nomes normalizados
+    // em ordem, chave i em nomeNormTexto[nomeNormInicio[i] .. [i + 1])
+    string nomeNormTexto;
+    vector<uint32_t> nomeNormInicio;
+    vector<IdProf> nomeNormIds;
+};
+
+inline void imagemMapaMontar(ImagemMapa &m) {
+    m.qtdCidades = qtdCidades;
+    m.hospital.assign(qtdCidades + 1, 0);
+    for (int v = 1; v <= qtdCidades; v++) m.hospital[v] = hospital[v];
+    m.cidadeInicio = cidades.inicio;
+    m.cidadeTexto = cidades.texto;
+    m.cidadePos = cidades.pos;
+
+    // Grafos em CSR puro
+    grafoCompactar(grafo);
+    grafoCompactar(grafoReverso);
+    m.grafoInicio = grafo.inicio;
+    m.grafoDestino = grafo.destino;
+    m.grafoPeso = grafo.peso;
+    m.reversoInicio = grafoReverso.inicio;
+    m.reversoDestino = grafoReverso.destino;
+    m.reversoPeso = grafoReverso.peso;
+}
+
+// Acrescenta as células de g, ordenadas pela chave, com as entradas de cada
+// uma contíguas; inicio fica relativo à primeira entrada de g
+inline void gradeAchatar(const GradeEspacial &g, vector<long long> &chaves, vector<uint32_t> &inicio,
+                         vector<EntradaGrade> &entradas) {
+    size_t primeira = chaves.size(), base = entradas.size();
+    for (const auto &cel : g.celulas) chaves.push_back(cel.first);
+    sort(chaves.begin() + primeira, chaves.end());
+    for (size_t c = primeira; c < chaves.size(); c++) {
+        inicio.push_back((uint32_t)(entradas.size() - base));
+        const auto &lista = g.celulas.at(chaves[c]);
+        entradas.insert(entradas.end(), lista.begin(), lista.end());
+    }
+    inicio.push_back((uint32_t)(entradas.size() - base));
+}
+
+inline void imagemProfissionaisMontar(ImagemProfissionais &p) {
+    // Registros e pool de nomes
+    p.profs.resize(cadastro.registros.size());
+    p.profTexto.clear();
+    for (size_t i = 0; i < p.profs.size(); i++) {
+        const Profissional &r = cadastro.registros[i];
+        p.profs[i] = {(uint32_t)p.profTexto.size(), (uint32_t)r.nome.size(),
+                      r.crm, r.pos.x, r.pos.y, r.especialidade, {0, 0, 0}};
+        p.profTexto += r.nome;
+    }
+
+    // Índices serializados
+    p.ordemNome.clear();
+    p.ordemNome.reserve(p.profs.size());
+    arvorePercorrer(arvoreNome, [&](IdProf id) { p.ordemNome.push_back(id); });
+    p.crmChaves = indiceCRM.chaves;
+    p.crmValores = indiceCRM.valores;
+
+    p.espInicio.assign(QTD_ESPECIALIDADES + 1, 0);
+    p.espIds.clear();
+    for (int i = 0; i < QTD_ESPECIALIDADES; i++) {
+        p.espInicio[i] = (uint32_t)p.espIds.size();
+        p.espIds.insert(p.espIds.end(), indiceEsp.lista[i].begin(), indiceEsp.lista[i].end());
+    }
+    p.espInicio[QTD_ESPECIALIDADES] = (uint32_t)p.espIds.size();
+
+    // Grade: células ordenadas pela chave, entradas contíguas por célula
+    p.gradeChaves.clear();
+    p.gradeInicio.clear();
+    p.gradeEntradas.clear();
+    p.gradeEntradas.reserve(grade.total);
+    gradeAchatar(grade, p.gradeChaves, p.gradeInicio, p.gradeEntradas);
+    p.minCx = grade.minCx; p.maxCx = grade.maxCx;
+    p.minCy = grade.minCy; p.maxCy = grade.maxCy;
+
+    // Grades por especialidade, no mesmo formato, uma após a outra
+    p.espGradeCelulas.clear();
+    p.espGradeLimites.clear();
+    p.espGradeChaves.clear();
+    p.espGradeInicio.clear();
+    p.espGradeEntradas.clear();
+    p.espGradeEntradas.reserve(p.espIds.size());
+    for (const GradeEspacial &g : indiceEsp.grade) {
+        p.espGradeCelulas.push_back((uint32_t)p.espGradeChaves.size());
+        p.espGradeLimites.push_back({g.minCx, g.maxCx, g.minCy, g.maxCy});
+        gradeAchatar(g, p.espGradeChaves, p.espGradeInicio, p.espGradeEntradas);
+    }
+    p.espGradeCelulas.push_back((uint32_t)p.espGradeChaves.size());
+}
+
+// Copia a árvore de nomes normalizados para os arrays da imagem
+inline void imagemNomesNormalizadosMontar(ImagemProfissionais &p) {
+    p.nomeNormTexto.clear();
+    p.nomeNormInicio.assign(1, 0);
+    p.nomeNormIds.clear();
+    p.nomeNormIds.reserve(nomesNormalizados.arvore.tamanho);
+    for (CursorChavesArvore c(nomesNormalizados.arvore, string_view()); !c.fim(); c.avancar()) {
+        p.nomeNormTexto += c.chave();
+        p.nomeNormInicio.push_back((uint32_t)p.nomeNormTexto.size());
+        p.nomeNormIds.push_back(c.id());
+    }
+}
+
+inline CursorChavesOrdenadas cursorNomesNormalizados(const ImagemProfissionais &p, string_view inicio) {
+    return CursorChavesOrdenadas(p.nomeNormTexto.data(), p.nomeNormInicio.data(), p.nomeNormIds.data(),
+                                 p.nomeNormIds.size(), inicio);
+}
+
+// Apontam a visão para as imagens, que precisam viver mais que ela
+inline void visaoMapa(Snapshot &s, const ImagemMapa &m) {
+    s.qtdCidades = m.qtdCidades;
+    s.hospital = m.hospital.data();
+    s.cidadeInicio = m.cidadeInicio.data();
+    s.cidadeTexto = m.cidadeTexto.data();
+    s.cidadePos = m.cidadePos.data();
+    s.grafo = {m.grafoInicio.data(), m.grafoDestino.data(), m.grafoPeso.data()};
+    s.reverso = {m.reversoInicio.data(), m.reversoDestino.data(), m.reversoPeso.data()};
+}
+
+inline void visaoProfissionais(Snapshot &s, const ImagemProfissionais &p) {
+    s.qtdProfs = (uint32_t)p.profs.size();
+    s.profs = p.profs.data();
+    s.profTexto = p.profTexto.data();
+    s.ordemNome = p.ordemNome.data();
+    s.crmChaves = p.crmChaves.data();
+    s.crmValores = p.crmValores.data();
+    s.crmCapacidade = p.crmChaves.size();
+    s.espInicio = p.espInicio.data();
+    s.espIds = p.espIds.data();
+    s.grade.qtdCelulas = (uint32_t)p.gradeChaves.size();
+    s.grade.chaves = p.gradeChaves.data();
+    s.grade.inicio = p.gradeInicio.data();
+    s.grade.entradas = p.gradeEntradas.data();
+    s.grade.minCx = p.minCx; s.grade.maxCx = p.maxCx;
+    s.grade.minCy = p.minCy; s.grade.maxCy = p.maxCy;
+    s.grade.total = p.profs.size();
+    visaoGradesEsp(s, p.espGradeCelulas.data(), p.espGradeLimites.data(), p.espGradeChaves.data(),
+                   p.espGradeInicio.data(), p.espGradeEntradas.data());
+}
+
+/* --- Gravação --- */
+struct EscritorSnapshot {
+    FILE *arq;
+    uint64_t pos = 0;
+    CabecalhoSnapshot cab;
+};
+
+inline void escreverSecao(EscritorSnapshot &e, SecaoSnapshot sec, const void *dados, size_t bytes) {
+    static const char zeros[8] = {0};
+    e.cab.inicio[sec] = e.pos;
+    e.cab.bytes[sec] = bytes;
+    if (bytes) fwrite(dados, 1, bytes, e.arq);
+    size_t pad = (8 - bytes % 8) % 8; // mantém cada seção alinhada em 8 bytes
+    fwrite(zeros, 1, pad, e.arq);
+    e.pos += bytes + pad;
+}
+
+template <class T>
+void escreverSecao(EscritorSnapshot &e, SecaoSnapshot sec, const vector<T> &v) {
+    escreverSecao(e, sec, v.data(), v.size() * sizeof(T));
+}
+
+// Grava em arquivo temporário e renomeia, para nunca deixar um snapshot pela metade
+inline bool snapshotSalvar(const char *caminho) {
+    Cronometro cron(MET_SNAPSHOT_SALVAR);
+    garantirMaterializado();
+    ImagemMapa m;
+    ImagemProfissionais p;
+    imagemMapaMontar(m);
+    imagemProfissionaisMontar(p);
+
+    string temp = string(caminho) + ".tmp";
+    EscritorSnapshot e;
+    e.arq = fopen(temp.c_str(), "wb");
+    if (!e.arq) return false;
+
+    memset(&e.cab, 0, sizeof e.cab);
+    memcpy(e.cab.magica, MAGICA_SNAPSHOT, sizeof MAGICA_SNAPSHOT);
+    e.cab.versao = VERSAO_SNAPSHOT;
+    e.cab.qtdCidades = m.qtdCidades;
+    e.cab.qtdProfs = (uint32_t)p.profs.size();
+    e.cab.lsn = lsnAtual;
+    e.cab.idLog = idLogEstado;
+    e.cab.minCx = p.minCx; e.cab.maxCx = p.maxCx;
+    e.cab.minCy = p.minCy; e.cab.maxCy = p.maxCy;
+    fwrite(&e.cab, sizeof e.cab, 1, e.arq); // reescrito no final
+    e.pos = sizeof e.cab;
+
+    escreverSecao(e, SEC_HOSPITAL, m.hospital);
+    escreverSecao(e, SEC_CIDADE_INICIO, m.cidadeInicio);
+    escreverSecao(e, SEC_CIDADE_TEXTO, m.cidadeTexto.data(), m.cidadeTexto.size());
+    escreverSecao(e, SEC_CIDADE_POS, m.cidadePos);
+    escreverSecao(e, SEC_GRAFO_INICIO, m.grafoInicio);
+    escreverSecao(e, SEC_GRAFO_DESTINO, m.grafoDestino);
+    escreverSecao(e, SEC_GRAFO_PESO, m.grafoPeso);
+    escreverSecao(e, SEC_REVERSO_INICIO, m.reversoInicio);
+    escreverSecao(e, SEC_REVERSO_DESTINO, m.reversoDestino);
+    escreverSecao(e, SEC_REVERSO_PESO, m.reversoPeso);
+    escreverSecao(e, SEC_PROFISSIONAIS, p.profs);
+    escreverSecao(e, SEC_PROF_TEXTO, p.profTexto.data(), p.profTexto.size());
+    escreverSecao(e, SEC_ORDEM_NOME, p.ordemNome);
+    escreverSecao(e, SEC_CRM_CHAVES, p.crmChaves);
+    escreverSecao(e, SEC_CRM_VALORES, p.crmValores);
+    escreverSecao(e, SEC_ESP_INICIO, p.espInicio);
+    escreverSecao(e, SEC_ESP_IDS, p.espIds);
+    escreverSecao(e, SEC_GRADE_CHAVES, p.gradeChaves);
+    escreverSecao(e, SEC_GRADE_INICIO, p.gradeInicio);
+    escreverSecao(e, SEC_GRADE_ENTRADAS, p.gradeEntradas);
+    escreverSecao(e, SEC_ESP_GRADE_CELULAS, p.espGradeCelulas);
+    escreverSecao(e, SEC_ESP_GRADE_LIMITES, p.espGradeLimites);
+    escreverSecao(e, SEC_ESP_GRADE_CHAVES, p.espGradeChaves);
+    escreverSecao(e, SEC_ESP_GRADE_INICIO, p.espGradeInicio);
+    escreverSecao(e, SEC_ESP_GRADE_ENTRADAS, p.espGradeEntradas);
+
+    e.cab.tamanhoArquivo = e.pos;
+    fseek(e.arq, 0, SEEK_SET);
+    fwrite(&e.cab, sizeof e.cab, 1, e.arq);
+    bool ok = fflush(e.arq) == 0 && fsync(fileno(e.arq)) == 0;
+    ok = (fclose(e.arq) == 0) && ok;
+    return ok && rename(temp.c_str(), caminho) == 0;
+}
+
+/* --- Leitura --- */
+// Confere cabeçalho, limites e tamanhos de cada seção; retorna a mensagem de
+// erro ou NULL. O conteúdo em si não é percorrido (custaria O(n) na partida).
+inline const char* snapshotValidar(const Snapshot &s) {
+    if (s.tamanho < sizeof(CabecalhoSnapshot)) return "arquivo truncado";
+    const CabecalhoSnapshot &c = *s.cab;
+    if (memcmp(c.magica, MAGICA_SNAPSHOT, sizeof MAGICA_SNAPSHOT) != 0) return "nao e um snapshot";
+    if (c.versao != VERSAO_SNAPSHOT) return "versao de snapshot incompativel";
+    if (c.tamanhoArquivo != s.tamanho) return "tamanho do arquivo inconsistente";
+    if (c.qtdCidades < 0 || c.qtdCidades > MAX_CIDADES) return "quantidade de cidades invalida";
+    for (int i = 0; i < QTD_SECOES; i++)
+        if (c.inicio[i] % 8 || c.inicio[i] > s.tamanho || c.bytes[i] > s.tamanho - c.inicio[i])
+            return "secao fora dos limites";
+
+    size_t n = c.qtdCidades, p = c.qtdProfs;
+    auto tem = [&](SecaoSnapshot sec, size_t bytes) { return c.bytes[sec] == bytes; };
+    if (!tem(SEC_HOSPITAL, n + 1) || !tem(SEC_CIDADE_INICIO, 4 * (n + 2)) ||
+        !tem(SEC_CIDADE_POS, sizeof(Coord) * (n + 1)) ||
+        !tem(SEC_GRAFO_INICIO, 4 * (n + 2)) || !tem(SEC_REVERSO_INICIO, 4 * (n + 2)) ||
+        !tem(SEC_PROFISSIONAIS, p * sizeof(RegistroSnapshot)) || !tem(SEC_ORDEM_NOME, 4 * p) ||
+        !tem(SEC_ESP_INICIO, 4 * (QTD_ESPECIALIDADES + 1)) || !tem(SEC_ESP_IDS, 4 * p) ||
+        !tem(SEC_GRADE_ENTRADAS, p * sizeof(EntradaGrade)) ||
+        c.bytes[SEC_GRADE_INICIO] != 4 * (c.bytes[SEC_GRADE_CHAVES] / 8 + 1) ||
+        c.bytes[SEC_CRM_CHAVES] != c.bytes[SEC_CRM_VALORES] ||
+        !tem(SEC_ESP_GRADE_CELULAS, 4 * (QTD_ESPECIALIDADES + 1)) ||
+        !tem(SEC_ESP_GRADE_LIMITES, sizeof(LimitesGrade) * QTD_ESPECIALIDADES) ||
+        !tem(SEC_ESP_GRADE_INICIO, 4 * (c.bytes[SEC_ESP_GRADE_CHAVES] / 8 + QTD_ESPECIALIDADES)) ||
+        !tem(SEC_ESP_GRADE_ENTRADAS, p * sizeof(EntradaGrade)))
+        return "tamanhos de secoes inconsistentes";
+
+    // As visões das especialidades são fatiadas por estes prefixos
+    // (QTD_ESPECIALIDADES + 1 valores cada)
+    const uint32_t *esp = secao<uint32_t>(s, SEC_ESP_INICIO);
+    const uint32_t *celulas = secao<uint32_t>(s, SEC_ESP_GRADE_CELULAS);
+    for (int i = 0; i < QTD_ESPECIALIDADES; i++)
+        if (esp[i] > esp[i + 1] || celulas[i] > celulas[i + 1]) return "especialidades inconsistentes";
+    if (esp[0] != 0 || esp[QTD_ESPECIALIDADES] != p || celulas[0] != 0 ||
+        celulas[QTD_ESPECIALIDADES] != c.bytes[SEC_ESP_GRADE_CHAVES] / 8)
+        return "especialidades inconsistentes";
+    return NULL;
+}
+
+inline bool snapshotAbrir(const char *caminho) {
+    Cronometro cron(MET_SNAPSHOT_ABRIR);
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0) {
+        cerr << "Nao foi possivel abrir " << caminho << "\n";
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        cerr << caminho << ": arquivo vazio\n";
+        return false;
+    }
+    void *m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) {
+        cerr << caminho << ": falha no mmap\n";
+        return false;
+    }
+
+    Snapshot s;
+    s.base = (const char*)m;
+    s.tamanho = st.st_size;
+    s.cab = (const CabecalhoSnapshot*)m;
+    if (const char *erro = snapshotValidar(s)) {
+        munmap(m, st.st_size);
+        cerr << caminho << ": " << erro << "\n";
+        return false;
+    }
+
+    s.qtdCidades = s.cab->qtdCidades;
+    s.qtdProfs = s.cab->qtdProfs;
+    s.hospital = secao<uint8_t>(s, SEC_HOSPITAL);
+    s.cidadeInicio = secao<uint32_t>(s, SEC_CIDADE_INICIO);
+    s.cidadeTexto = secao<char>(s, SEC_CIDADE_TEXTO);
+    s.cidadePos = secao<Coord>(s, SEC_CIDADE_POS);
+    s.grafo = {secao<int>(s, SEC_GRAFO_INICIO), secao<int>(s, SEC_GRAFO_DESTINO),
+               secao<int>(s, SEC_GRAFO_PESO)};
+    s.reverso = {secao<int>(s, SEC_REVERSO_INICIO), secao<int>(s, SEC_REVERSO_DESTINO),
+                 secao<int>(s, SEC_REVERSO_PESO)};
+    s.profs = secao<RegistroSnapshot>(s, SEC_PROFISSIONAIS);
+    s.profTexto = secao<char>(s, SEC_PROF_TEXTO);
+    s.ordemNome = secao<IdProf>(s, SEC_ORDEM_NOME);
+    s.crmChaves = secao<int>(s, SEC_CRM_CHAVES);
+    s.crmValores = secao<IdProf>(s, SEC_CRM_VALORES);
+    s.crmCapacidade = s.cab->bytes[SEC_CRM_CHAVES] / 4;
+    s.espInicio = secao<uint32_t>(s, SEC_ESP_INICIO);
+    s.espIds = secao<IdProf>(s, SEC_ESP_IDS);
+    s.grade.qtdCelulas = (uint32_t)(s.cab->bytes[SEC_GRADE_CHAVES] / 8);
+    s.grade.chaves = secao<long long>(s, SEC_GRADE_CHAVES);
+    s.grade.inicio = secao<uint32_t>(s, SEC_GRADE_INICIO);
+    s.grade.entradas = secao<EntradaGrade>(s, SEC_GRADE_ENTRADAS);
+    s.grade.minCx = s.cab->minCx; s.grade.maxCx = s.cab->maxCx;
+    s.grade.minCy = s.cab->minCy; s.grade.maxCy = s.cab->maxCy;
+    s.grade.total = s.cab->qtdProfs;
+    visaoGradesEsp(s, secao<uint32_t>(s, SEC_ESP_GRADE_CELULAS), secao<LimitesGrade>(s, SEC_ESP_GRADE_LIMITES),
+                   secao<long long>(s, SEC_ESP_GRADE_CHAVES), secao<uint32_t>(s, SEC_ESP_GRADE_INICIO),
+                   secao<EntradaGrade>(s, SEC_ESP_GRADE_ENTRADAS));
+    s.ativo = true;
+    snap = s;
+    lsnAtual = s.cab->lsn;
+    idLogEstado = s.cab->idLog;
+    return true;
+}
+
+// Copia o conteúdo mapeado para as estruturas em memória e desfaz o mapeamento
+inline void garantirMaterializado() {
+    if (!snap.ativo) return;
+    const Snapshot &s = snap;
+    const CabecalhoSnapshot &c = *s.cab;
+    int n = c.qtdCidades;
+
+    qtdCidades = n;
+    cidades = CadastroCidades();
+    cidades.texto.assign(s.cidadeTexto, s.cidadeInicio[n + 1]);
+    cidades.inicio.assign(s.cidadeInicio, s.cidadeInicio + n + 2);
+    cidades.pos.assign(s.cidadePos, s.cidadePos + n + 1);
+    hospital.palavras.assign((n >> 6) + 1, 0);
+    for (int v = 1; v <= n; v++) {
+        if (s.hospital[v]) bitsetDefinir(hospital, v, true);
+        cidadeIndexar(cidades, v);
+    }
+    auto carregarCSR = [&](Grafo &g, SecaoSnapshot ini, SecaoSnapshot dest, SecaoSnapshot peso) {
+        g = Grafo();
+        g.n = n;
+        g.inicio.assign(secao<int>(s, ini), secao<int>(s, ini) + n + 2);
+        g.destino.assign(secao<int>(s, dest), secao<int>(s, dest) + c.bytes[dest] / 4);
+        g.peso.assign(secao<int>(s, peso), secao<int>(s, peso) + c.bytes[peso] / 4);
+        g.cabeca.assign(n + 1, -1);
+    };
+    carregarCSR(grafo, SEC_GRAFO_INICIO, SEC_GRAFO_DESTINO, SEC_GRAFO_PESO);
+    carregarCSR(grafoReverso, SEC_REVERSO_INICIO, SEC_REVERSO_DESTINO, SEC_REVERSO_PESO);
+
+    cadastro = CadastroProfissionais();
+    cadastro.registros.reserve(c.qtdProfs);
+    for (uint32_t i = 0; i < c.qtdProfs; i++) {
+        const RegistroSnapshot &r = s.profs[i];
+        cadastroInserir(cadastro, snapNomeProf(s, i), r.especialidade, r.crm, {r.x, r.y});
+    }
+
+    vector<pair<string_view, IdProf>> pares(c.qtdProfs);
+    for (uint32_t i = 0; i < c.qtdProfs; i++)
+        pares[i] = {prof(s.ordemNome[i]).nome, s.ordemNome[i]};
+    arvoreConstruir(arvoreNome, pares);
+    nomesNormalizadosConstruir(nomesNormalizados);
+
+    indiceCRM = IndiceCRM();
+    indiceCRM.chaves.assign(s.crmChaves, s.crmChaves + s.crmCapacidade);
+    indiceCRM.valores.assign(s.crmValores, s.crmValores + s.crmCapacidade);
+    indiceCRM.tamanho = c.qtdProfs;
+
+    grade = GradeEspacial();
+    for (uint32_t i = 0; i < c.qtdProfs; i++)
+        gradeInserir(grade, {s.profs[i].x, s.profs[i].y}, i);
+
+    indiceEsp = IndiceEspecialidade();
+    for (int i = 0; i < QTD_ESPECIALIDADES; i++)
+        for (uint32_t j = s.espInicio[i]; j < s.espInicio[i + 1]; j++)
+            espInserir(indiceEsp, (IdEsp)i, s.espIds[j]);
+
+    if (tabelaHosp.ativa) tabelaConstruir(tabelaHosp);
+    alcanceConstruir(alcance);
+    cacheHospitais = CacheHospitais();
+    indiceCH.pronto = false;
+
+    munmap((void*)s.base, s.tamanho);
+    snap = Snapshot();
+}
+
+/* ===========================
+   POOL DE TRABALHO (ROUBO)
+=========================== */
+// Threads fixas para consultas em lote. Um lote é o intervalo [0, n): cada
+// participante (as threads do pool e quem chamou) começa com uma fatia
+// contígua e consome blocos pela frente; quem esvazia a sua rouba a metade
+// final da fatia de outro. Início e fim de cada fatia ficam num único atomic
+// de 64 bits, então dono e ladrões disputam só por CAS.
+const uint32_t BLOCO_LOTE = 16;
+
+struct alignas(64) FatiaLote {
+    atomic<uint64_t> faixa{0};        // (inicio << 32) | fim
+};
+
+struct PoolTrabalho {
+    int participantes;                // threads + quem chama poolExecutar
+    vector<thread> threads;
+    unique_ptr<FatiaLote[]> fatias;   // a última é de quem chama
+    function<void(size_t, size_t)> tarefa;
+    mutex m, lote;                    // lote: um lote por vez
+    condition_variable temLote, terminou;
+    uint64_t geracao = 0;
+    int pendentes = 0;
+    bool parar = false;
+
+    explicit PoolTrabalho(int n);
+    ~PoolTrabalho();
+};
+
+inline uint64_t faixaDe(uint64_t ini, uint64_t fim) {
+    return ini << 32 | fim;
+}
+
+// Tira até BLOCO_LOTE itens do início da própria fatia
+inline bool fatiaPegar(FatiaLote &f, size_t &ini, size_t &fim) {
+    uint64_t atual = f.faixa.load();
+    for (;;) {
+        uint32_t a = (uint32_t)(atual >> 32), b = (uint32_t)atual;
+        if (a >= b) return false;
+        uint32_t meio = min(b, a + BLOCO_LOTE);
+        if (f.faixa.compare_exchange_weak(atual, faixaDe(meio, b))) {
+            ini = a;
+            fim = meio;
+            return true;
+        }
+    }
+}
+
+// Passa para a própria fatia (vazia) a metade final da fatia de outro
+inline bool fatiaRoubar(PoolTrabalho &p, int eu) {
+    for (int k = 1; k < p.participantes; k++) {
+        FatiaLote &vitima = p.fatias[(eu + k) % p.participantes];
+        uint64_t atual = vitima.faixa.load();
+        for (;;) {
+            uint32_t a = (uint32_t)(atual >> 32), b = (uint32_t)atual;
+            if (a >= b) break;
+            uint32_t meio = a + (b - a) / 2;
+            if (vitima.faixa.compare_exchange_weak(atual, faixaDe(a, meio))) {
+                p.fatias[eu].faixa.store(faixaDe(meio, b));
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+inline void poolParticipar(PoolTrabalho &p, int eu) {
+    size_t ini, fim;
+    do {
+        while (fatiaPegar(p.fatias[eu], ini, fim)) p.tarefa(ini, fim);
+    } while (fatiaRoubar(p, eu));
+}
+
+inline void poolTrabalhador(PoolTrabalho &p, int eu) {
+    uint64_t visto = 0;
+    for (;;) {
+        {
+            unique_lock<mutex> trava(p.m);
+            p.temLote.wait(trava, [&] { return p.parar || p.geracao != visto; });
+            if (p.parar) return;
+            visto = p.geracao;
+        }
+        poolParticipar(p, eu);
+        lock_guard<mutex> trava(p.m);
+        if (--p.pendentes == 0) p.terminou.notify_one();
+    }
+}
+
+inline PoolTrabalho::PoolTrabalho(int n) : participantes(max(n, 1)) {
+    fatias.reset(new FatiaLote[participantes]);
+    for (int i = 0; i + 1 < participantes; i++)
+        threads.emplace_back(poolTrabalhador, ref(*this), i);
+}
+
+inline PoolTrabalho::~PoolTrabalho() {
+    {
+        lock_guard<mutex> trava(m);
+        parar = true;
+    }
+    temLote.notify_all();
+    for (thread &t : threads) t.join();
+}
+
+// Pool compartilhado, com uma thread por núcleo (contando quem chama)
+inline PoolTrabalho& poolLote() {
+    static PoolTrabalho p((int)thread::hardware_concurrency());
+    return p;
+}
+
+// Chama f(i) para todo i em [0, n) e só retorna quando todos terminaram.
+// f roda em várias threads ao mesmo tempo e não pode abrir outro lote no
+// mesmo pool.
+template <class F>
+void poolExecutar(PoolTrabalho &p, size_t n, F f) {
+    if (n == 0) return;
+    lock_guard<mutex> umPorVez(p.lote);
+    int total = p.participantes;
+    if (total == 1 || n <= BLOCO_LOTE || n > UINT32_MAX) {
+        for (size_t i = 0; i < n; i++) f(i);
+        return;
+    }
+    p.tarefa = [&](size_t ini, size_t fim) {
+        for (size_t i = ini; i < fim; i++) f(i);
+    };
+    for (int i = 0; i < total; i++)
+        p.fatias[i].faixa.store(faixaDe(n * i / total, n * (i + 1) / total));
+    {
+        lock_guard<mutex> trava(p.m);
+        p.pendentes = total - 1;
+        p.geracao++;
+    }
+    p.temLote.notify_all();
+    poolParticipar(p, total - 1);
+
+    unique_lock<mutex> trava(p.m);
+    p.terminou.wait(trava, [&] { return p.pendentes == 0; });
+}
+
+/* ===========================
+   JUNÇÃO PROFISSIONAIS x HOSPITAIS
+=========================== */
+// Relatório de escala, em linha reta pelas coordenadas: o hospital mais
+// próximo de cada profissional, ou os profissionais a até R de cada hospital.
+// Os dois lados usam índice espacial. Os hospitais com coordenada vão para
+// uma grade própria, com células de ~1 hospital; os profissionais já estão
+// na grade geral. As células de profissionais são agrupadas em blocos do
+// tamanho das células de hospitais. Em cada bloco, o hospital mais próximo
+// do centro (a uma distância d0) limita os candidatos aos que estão a até
+// d0 + 2 * lado do centro: para qualquer ponto p do bloco, o mais próximo de
+// p está a no máximo dist(p, centro) + d0 dele, e o centro está a no máximo
+// lado de p. Nos blocos da borda do plano, o centro cortado a INT_MIN/INT_MAX
+// se afasta até delta do centro real, e o limite cresce 2 * delta. O trabalho é dividido entre as threads do pool por bloco (ou
+// por hospital). O desempate é pelo menor ID, então o resultado não depende
+// da ordem das threads.
+struct HospitalMaisProximo {
+    int hospital = -1;          // -1: nenhum hospital com coordenada
+    long long dist2 = 0;
+};
+
+struct EquipeHospital {
+    int hospital;
+    vector<Vizinho> profissionais; // a até o raio, do mais perto ao mais longe
+};
+
+inline GradeEspacial gradeHospitaisMontar() {
+    GradeEspacial g;
+    vector<int> ids;
+    long long x0 = LLONG_MAX, x1 = LLONG_MIN, y0 = LLONG_MAX, y1 = LLONG_MIN;
+    for (int v = 1; v <= qtdCidades; v++) {
+        Coord c = cidades.pos[v];
+        if (!hospital[v] || !temPosicao(c)) continue;
+        ids.push_back(v);
+        x0 = min<long long>(x0, c.x); x1 = max<long long>(x1, c.x);
+        y0 = min<long long>(y0, c.y); y1 = max<long long>(y1, c.y);
+    }
+    if (ids.empty()) return g;
+    double area = (double)(x1 - x0 + 1) * (double)(y1 - y0 + 1);
+    g.lado = (int)min((double)(INT_MAX / 4), max(1.0, sqrt(area / ids.size())));
+    for (int v : ids) gradeInserir(g, cidades.pos[v], (IdProf)v);
+    return g;
+}
+
+// Hospital mais próximo de cada profissional (índice = IdProf)
+inline vector<HospitalMaisProximo> atribuirHospitais(PoolTrabalho &p = poolLote()) {
+    Cronometro cron(MET_JUNCAO);
+    vector<HospitalMaisProximo> res(cadastro.registros.size());
+    GradeEspacial gh = gradeHospitaisMontar();
+    if (gh.total == 0) return res;
+
+    // Blocos de f x f células de profissionais, ordenados pela chave do bloco
+    typedef pair<const long long, vector<EntradaGrade>> Celula;
+    const int f = max(1, gh.lado / grade.lado);
+    const long long ladoBloco = (long long)f * grade.lado;
+    vector<pair<long long, const Celula*>> celulas;
+    celulas.reserve(grade.celulas.size());
+    for (const Celula &cel : grade.celulas) {
+        int cx = (int)(cel.first >> 32), cy = (int)(uint32_t)cel.first;
+        celulas.push_back({chaveCelula(celulaDe(cx, f), celulaDe(cy, f)), &cel});
+    }
+    sort(celulas.begin(), celulas.end(),
+         [](const auto &a, const auto &b) { return a.first < b.first; });
+    vector<size_t> blocos; // início de cada bloco em 'celulas'
+    for (size_t i = 0; i < celulas.size(); i++)
+        if (i == 0 || celulas[i].first != celulas[i - 1].first) blocos.push_back(i);
+    blocos.push_back(celulas.size());
+
+    poolExecutar(p, blocos.size() - 1, [&](size_t b) {
+        static thread_local vector<EntradaGrade> candidatos;
+        long long chave = celulas[blocos[b]].first;
+        long long bx = chave >> 32, by = (int)(uint32_t)chave;
+        long long rx = bx * ladoBloco + ladoBloco / 2, ry = by * ladoBloco + ladoBloco / 2;
+        Coord centro = {(int)max<long long>(INT_MIN, min<long long>(INT_MAX, rx)),
+                        (int)max<long long>(INT_MIN, min<long long>(INT_MAX, ry))};
+        long long delta = llabs(rx - centro.x) + llabs(ry - centro.y);
+        vector<Vizinho> h0 = gradeKMelhores(gh, centro, 1, [](const EntradaGrade &) { return true; });
+        long long raio = (long long)ceil(sqrt((double)h0[0].first)) + 1 + 2 * (ladoBloco + delta);
+        long long r2 = quadradoSaturado(raio);
+        candidatos.clear();
+        gradeVisitarJanela(gh, centro, raio, [&](const EntradaGrade &e) {
+            if (dist2(centro, e.x, e.y) <= r2) candidatos.push_back(e);
+        });
+        for (size_t i = blocos[b]; i < blocos[b + 1]; i++) {
+            for (const EntradaGrade &pt : celulas[i].second->second) {
+                HospitalMaisProximo melhor;
+                for (const EntradaGrade &h : candidatos) {
+                    long long d2 = dist2({pt.x, pt.y}, h.x, h.y);
+                    if (melhor.hospital == -1 || d2 < melhor.dist2 ||
+                        (d2 == melhor.dist2 && (int)h.id < melhor.hospital))
+                        melhor = {(int)h.id, d2};
+                }
+                res[pt.id] = melhor;
+            }
+        }
+    });
+    return res;
+}
+
+// Profissionais a até 'raio' de cada hospital com coordenada, por ID do hospital
+inline vector<EquipeHospital> profissionaisPorHospital(int raio, PoolTrabalho &p = poolLote()) {
+    Cronometro cron(MET_JUNCAO);
+    GradeEspacial gh = gradeHospitaisMontar();
+    // Hospitais na ordem das células da sua grade: threads vizinhas no lote
+    // leem as mesmas regiões da grade de profissionais
+    vector<long long> chaves;
+    for (const auto &cel : gh.celulas) chaves.push_back(cel.first);
+    sort(chaves.begin(), chaves.end());
+    vector<EntradaGrade> hosp;
+    hosp.reserve(gh.total);
+    for (long long k : chaves) {
+        const auto &lista = gh.celulas.at(k);
+        hosp.insert(hosp.end(), lista.begin(), lista.end());
+    }
+
+    vector<EquipeHospital> res(hosp.size());
+    poolExecutar(p, hosp.size(), [&](size_t i) {
+        uint64_t pontos = 0;
+        res[i].hospital = (int)hosp[i].id;
+        vector<Vizinho> &perto = res[i].profissionais;
+        gradeColetarRaio(grade, {hosp[i].x, hosp[i].y}, raio, perto, pontos);
+        sort(perto.begin(), perto.end());
+    });
+    sort(res.begin(), res.end(),
+         [](const EquipeHospital &a, const EquipeHospital &b) { return a.hospital < b.hospital; });
+    return res;
+}
+
+// Várias consultas de raio sobre a grade em memória de uma vez, com o
+// resultado de cada centro na posição dele em 'centros'. As consultas de
+// janela pequena rodam uma a uma, na ordem das células dos centros, para que
+// threads vizinhas leiam as mesmas regiões da grade. As que varreriam todos
+// os pontos são agrupadas: cada grupo percorre os arrays x[] e y[] em blocos
+// que cabem no cache L1 e passa cada bloco pelo kernel para todos os centros
+// do grupo antes de seguir.
+const size_t CONSULTAS_POR_VARREDURA = 16;
+const size_t PONTOS_POR_BLOCO_VARREDURA = 2048;
+
+inline vector<vector<Vizinho>> gradeRaioLote(const GradeEspacial &g, const vector<Coord> &centros,
+                                             int raio, PoolTrabalho &p = poolLote()) {
+    vector<pair<long long, uint32_t>> janela;
+    vector<uint32_t> varredura;
+    for (size_t i = 0; i < centros.size(); i++) {
+        Coord c = centros[i];
+        if (gradeVarrerTudo(g, c, raio))
+            varredura.push_back((uint32_t)i);
+        else
+            janela.push_back({chaveCelula(celulaDe(c.x, g.lado), celulaDe(c.y, g.lado)), (uint32_t)i});
+    }
+    sort(janela.begin(), janela.end());
+    size_t grupos = (varredura.size() + CONSULTAS_POR_VARREDURA - 1) / CONSULTAS_POR_VARREDURA;
+
+    vector<vector<Vizinho>> res(centros.size());
+    atomic<uint64_t> total{0};
+    poolExecutar(p, grupos + janela.size(), [&](size_t t) {
+        if (t < grupos) {
+            size_t ini = t * CONSULTAS_POR_VARREDURA;
+            size_t fim = min(varredura.size(), ini + CONSULTAS_POR_VARREDURA);
+            for (size_t b = 0; b < g.total; b += PONTOS_POR_BLOCO_VARREDURA)
+                for (size_t k = ini; k < fim; k++)
+                    gradeVarrerRaio(g, b, min(g.total, b + PONTOS_POR_BLOCO_VARREDURA),
+                                    centros[varredura[k]], raio, res[varredura[k]]);
+            for (size_t k = ini; k < fim; k++) sort(res[varredura[k]].begin(), res[varredura[k]].end());
+            total.fetch_add((fim - ini) * g.total, memory_order_relaxed);
+        } else {
+            uint32_t i = janela[t - grupos].second;
+            uint64_t pontos = 0;
+            gradeColetarRaio(g, centros[i], raio, res[i], pontos);
+            sort(res[i].begin(), res[i].end());
+            total.fetch_add(pontos, memory_order_relaxed);
+        }
+    });
+    metricaRegistrar(MET_PROXIMIDADE_PONTOS, total.load());
+    return res;
+}
+
+/* ===========================
+   BUSCA DE HOSPITAL (DIJKSTRA)
+=========================== */
+enum ModoHospital { MODO_DIJKSTRA, MODO_TABELA, MODO_CH, MODO_TRECHOS };
+inline ModoHospital modoHospital = MODO_DIJKSTRA;
+
+// Vetores de trabalho do Dijkstra, reaproveitados entre as consultas de uma
+// mesma thread. Só as posições tocadas pela consulta anterior são
+// restauradas, então o custo não depende do total de cidades.
+struct BuscaDijkstra {
+    vector<Custo> dist;
+    vector<int> pred, tocados;
+    vector<pair<Custo, int>> heap;
+};
+
+inline thread_local BuscaDijkstra buscaLocal;
+
+// Dijkstra com heap a partir da origem; para quando k hospitais foram
+// assentados e devolve a rota até cada um, do mais perto ao mais longe (com
+// 'unitario', cada via vale 1 e o custo é o número de trechos). Se
+// 'assentadas' não for nulo, recebe as cidades assentadas. Serve para o
+// grafo em memória (com o bitset de hospitais) e para o CSR e o array de
+// hospitais do snapshot mapeado.
+template <class G, class H>
+vector<RotaHospital> kHospitaisDijkstra(const G &g, const H &ehHospital, int n, int inicio, int k,
+                                        bool unitario = false, vector<int> *assentadas = NULL,
+                                        BuscaDijkstra &b = buscaLocal) {
+    vector<RotaHospital> res;
+    if ((int)b.dist.size() < n + 1) {
+        b.dist.resize(n + 1, DIST_INF);
+        b.pred.resize(n + 1, -1);
+    }
+    for (int v : b.tocados) {
+        b.dist[v] = DIST_INF;
+        b.pred[v] = -1;
+    }
+    b.tocados.clear();
+    b.heap.clear();
+
+    vector<Custo> &dist = b.dist;
+    vector<int> &pred = b.pred;
+    vector<pair<Custo, int>> &heap = b.heap;
+    auto maior = greater<pair<Custo, int>>();
+    dist[inicio] = 0;
+    b.tocados.push_back(inicio);
+    heap.push_back({0, inicio});
+
+    uint64_t qtdAssentados = 0;
+    while (!heap.empty() && (int)res.size() < k) {
+        pop_heap(heap.begin(), heap.end(), maior);
+        auto [d, atual] = heap.back();
+        heap.pop_back();
+        if (d != dist[atual]) continue;
+        qtdAssentados++;
+        if (assentadas) assentadas->push_back(atual);
+        if (ehHospital[atual]) {
+            RotaHospital r;
+            r.hospital = atual;
+            r.custo = d;
+            for (int v = atual; v != -1; v = pred[v]) r.caminho.push_back(v);
+            reverse(r.caminho.begin(), r.caminho.end());
+            res.push_back(move(r));
+            if ((int)res.size() == k) break;
+        }
+        paraCadaVizinho(g, atual, [&](int i, int w) {
+            if (unitario) w = 1;
+            if (d + w < dist[i]) {
+                if (dist[i] == DIST_INF) b.tocados.push_back(i);
+                dist[i] = d + w;
+                pred[i] = atual;
+                heap.push_back({d + w, i});
+                push_heap(heap.begin(), heap.end(), maior);
+            }
+        });
+    }
+    metricaRegistrar(MET_ROTA_NOS, qtdAssentados);
+    return res;
+}
+
+// Só o mais próximo
+template <class G, class H>
+RotaHospital rotaDijkstra(const G &g, const H &ehHospital, int n, int inicio,
+                          BuscaDijkstra &b = buscaLocal) {
+    vector<RotaHospital> r = kHospitaisDijkstra(g, ehHospital, n, inicio, 1, false, NULL, b);
+    return r.empty() ? RotaHospital() : move(r[0]);
+}
+
+/* ===========================
+   BUSCA DE HOSPITAL (TRECHOS)
+=========================== */
+// Modo "menor número de trechos": BFS que alterna a direção a cada nível
+// (direction-optimizing). Top-down expande a fronteira pelas vias de saída;
+// quando as vias da fronteira passam de 1/ALFA_BFS das que restam aos não
+// visitados, vira bottom-up: cada cidade não visitada procura, pelas vias de
+// entrada, um vizinho na fronteira e para no primeiro. Volta a top-down
+// quando a fronteira cai abaixo de n/BETA_BFS cidades. Visitados, fronteira
+// e hospitais são bitsets; o bottom-up percorre 64 cidades por palavra e
+// acha o hospital do nível com um AND.
+//
+// Empates: vence o hospital de menor ID no nível mais raso, e a rota volta
+// pelo predecessor de menor ID no nível anterior. O resultado é, portanto, o
+// de uma BFS comum com as mesmas regras, seja qual for a direção de cada
+// nível. O custo da rota é o número de trechos.
+const int ALFA_BFS = 14, BETA_BFS = 24;
+
+struct BuscaLargura {
+    vector<uint64_t> visitado, fronteira, proxima;
+    vector<int> nivel, lista, proxLista, tocados;
+};
+
+inline thread_local BuscaLargura larguraLocal;
+
+// Vias que saem de v, no CSR e no buffer; o buffer de v é percorrido, mas
+// ao longo de uma busca isso soma no máximo o tamanho do buffer
+inline int grauSaida(const Grafo &g, int v) {
+    int grau = g.inicio[v + 1] - g.inicio[v];
+    for (int e = g.cabeca[v]; e != -1; e = g.bufProx[e]) grau++;
+    return grau;
+}
+
+// Se alguma via de entrada de v vem de uma cidade marcada em bits
+inline bool entradaEm(const Grafo &rev, int v, const vector<uint64_t> &bits) {
+    auto marcado = [&](int u) { return (bits[u >> 6] >> (u & 63)) & 1; };
+    for (int e = rev.inicio[v]; e < rev.inicio[v + 1]; e++)
+        if (marcado(rev.destino[e])) return true;
+    for (int e = rev.cabeca[v]; e != -1; e = rev.bufProx[e])
+        if (marcado(rev.bufDestino[e])) return true;
+    return false;
+}
+
+inline RotaHospital rotaLargura(const Grafo &g, const Grafo &rev, const BitsetCidades &hosp,
+                                int n, int inicio, BuscaLargura &b = larguraLocal) {
+    RotaHospital r;
+    size_t palavras = (size_t)(n >> 6) + 1;
+    // Poucas cidades tocadas na consulta anterior: limpa só os bits delas
+    if (b.tocados.size() * 8 < b.visitado.size())
+        for (int v : b.tocados) b.visitado[v >> 6] &= ~(1ull << (v & 63));
+    else
+        fill(b.visitado.begin(), b.visitado.end(), 0);
+    b.tocados.clear();
+    if (b.visitado.size() < palavras) b.visitado.resize(palavras, 0);
+    if (b.nivel.size() < (size_t)n + 1) b.nivel.resize(n + 1);
+
+    auto visto = [&](int v) { return (b.visitado[v >> 6] >> (v & 63)) & 1; };
+    auto marcar = [&](int v, int nv) {
+        b.visitado[v >> 6] |= 1ull << (v & 63);
+        b.nivel[v] = nv;
+        b.tocados.push_back(v);
+    };
+    auto hospPalavra = [&](size_t w) { return w < hosp.palavras.size() ? hosp.palavras[w] : 0; };
+
+    long long arestasFronteira = grauSaida(g, inicio);
+    long long arestasRestantes = (long long)(g.destino.size() + g.bufDestino.size()) - arestasFronteira;
+    size_t tamFronteira = 1;
+    bool baixoCima = false;
+    int achado = hosp[inicio] ? inicio : -1;
+    marcar(inicio, 0);
+    b.lista.assign(1, inicio);
+
+    for (int nv = 1; achado == -1 && tamFronteira > 0; nv++) {
+        if (!baixoCima && arestasFronteira > arestasRestantes / ALFA_BFS) {
+            b.fronteira.assign(palavras, 0);
+            for (int u : b.lista) b.fronteira[u >> 6] |= 1ull << (u & 63);
+            baixoCima = true;
+        } else if (baixoCima && tamFronteira < (size_t)n / BETA_BFS) {
+            b.lista.clear();
+            for (size_t w = 0; w < palavras; w++)
+                for (uint64_t bits = b.fronteira[w]; bits; bits &= bits - 1)
+                    b.lista.push_back((int)(w << 6) + __builtin_ctzll(bits));
+            baixoCima = false;
+        }
+
+        arestasFronteira = 0;
+        if (!baixoCima) {
+            b.proxLista.clear();
+            for (int u : b.lista) {
+                paraCadaVizinho(g, u, [&](int v, int) {
+                    if (visto(v)) return;
+                    marcar(v, nv);
+                    b.proxLista.push_back(v);
+                    arestasFronteira += grauSaida(g, v);
+                    if (hosp[v] && (achado == -1 || v < achado)) achado = v;
+                });
+            }
+            swap(b.lista, b.proxLista);
+            tamFronteira = b.lista.size();
+        } else {
+            b.proxima.assign(palavras, 0);
+            tamFronteira = 0;
+            for (size_t w = 0; w < palavras; w++) {
+                uint64_t livres = ~b.visitado[w];
+                if (w == 0) livres &= ~1ull; // o ID 0 não é cidade
+                if (w == palavras - 1 && ((n + 1) & 63)) livres &= (1ull << ((n + 1) & 63)) - 1;
+                uint64_t novos = 0;
+                for (; livres; livres &= livres - 1) {
+                    int bit = __builtin_ctzll(livres);
+                    if (entradaEm(rev, (int)(w << 6) + bit, b.fronteira)) novos |= 1ull << bit;
+                }
+                if (!novos) continue;
+                b.proxima[w] = novos;
+                tamFronteira += __builtin_popcountll(novos);
+                for (uint64_t bits = novos; bits; bits &= bits - 1) {
+                    int v = (int)(w << 6) + __builtin_ctzll(bits);
+                    marcar(v, nv);
+                    arestasFronteira += grauSaida(g, v);
+                }
+                uint64_t h = novos & hospPalavra(w);
+                if (h && achado == -1) achado = (int)(w << 6) + __builtin_ctzll(h);
+            }
+            swap(b.fronteira, b.proxima);
+        }
+        arestasRestantes -= arestasFronteira;
+    }
+    metricaRegistrar(MET_ROTA_NOS, b.tocados.size());
+    if (achado == -1) return r;
+
+    r.hospital = achado;
+    r.custo = b.nivel[achado];
+    for (int v = achado;; ) {
+        r.caminho.push_back(v);
+        if (b.nivel[v] == 0) break;
+        int ant = INT_MAX;
+        paraCadaVizinho(rev, v, [&](int u, int) {
+            if (u < ant && visto(u) && b.nivel[u] == b.nivel[v] - 1) ant = u;
+        });
+        v = ant;
+    }
+    reverse(r.caminho.begin(), r.caminho.end());
+    return r;
+}
+
+inline RotaHospital rotaHospital(int inicio) {
+    Cronometro cron(MET_ROTA_HOSPITAL);
+    if (snap.ativo) {
+        if (modoHospital == MODO_DIJKSTRA)
+            return rotaDijkstra(snap.grafo, snap.hospital, snap.qtdCidades, inicio);
+        garantirMaterializado();
+    }
+    // Sem hospital alcançável: resposta imediata pelo índice de componentes
+    if (!alcancaHospital(inicio)) return RotaHospital();
+    switch (modoHospital) {
+        case MODO_TABELA: return rotaTabela(tabelaHosp, inicio);
+        case MODO_CH:
+            // Índice desatualizado por um cadastro: a reconstrução pode levar
+            // segundos, então só acontece a pedido (modoHospitalDefinir)
+            if (!indiceCH.pronto) return rotaDijkstra(grafo, hospital, qtdCidades, inicio);
+            return rotaCH(indiceCH, inicio);
+        case MODO_TRECHOS: return rotaLargura(grafo, grafoReverso, hospital, qtdCidades, inicio);
+        default: return rotaDijkstra(grafo, hospital, qtdCidades, inicio);
+    }
+}
+
+// Os k hospitais mais próximos de inicio, por tempo ou por número de trechos,
+// com a rota até cada um; usa e alimenta o cache de hospitais alternativos.
+// Menos de k na resposta: não há mais hospitais alcançáveis.
+inline vector<RotaHospital> kHospitais(int inicio, int k, bool trechos) {
+    Cronometro cron(MET_K_HOSPITAIS);
+    if (k < 1) return {};
+    size_t chave = chaveCacheHospitais(inicio, trechos);
+    vector<RotaHospital> res;
+    if (cacheHospitaisBuscar(cacheHospitais, chave, k, res)) return res;
+
+    if (!snap.ativo && !alcancaHospital(inicio)) return {};
+    static thread_local vector<int> bola;
+    bola.clear();
+    res = snap.ativo ? kHospitaisDijkstra(snap.grafo, snap.hospital, snap.qtdCidades, inicio, k, trechos, &bola)
+                     : kHospitaisDijkstra(grafo, hospital, qtdCidades, inicio, k, trechos, &bola);
+    cacheHospitaisGuardar(cacheHospitais, chave, k, totalCidades(), res, bola);
+    return res;
+}
+
+// Troca o modo de busca; só o índice do novo modo é mantido em memória
+inline void modoHospitalDefinir(ModoHospital m) {
+    tabelaHosp = TabelaHospital();
+    indiceCH = IndiceCH();
+    if (m == MODO_TABELA) tabelaConstruir(tabelaHosp);
+    else if (m == MODO_CH) chConstruir(indiceCH);
+    modoHospital = m;
+}
+
+/* ===========================
+   RELATÓRIO DE MÉTRICAS
+=========================== */
+// Soma das threads vivas e encerradas no momento da chamada
+inline unique_ptr<MetricasThread> metricasTotais() {
+    unique_ptr<MetricasThread> t(new MetricasThread());
+    lock_guard<mutex> trava(metricas.m);
+    metricasSomar(*t, metricas.encerradas);
+    for (const MetricasThread *m : metricas.vivas) metricasSomar(*t, *m);
+    return t;
+}
+
+struct ResumoSerie {
+    uint64_t n = 0, soma = 0, maximo = 0;
+    uint64_t p50 = 0, p90 = 0, p99 = 0, p999 = 0;
+};
+
+inline ResumoSerie metricaResumir(const MetricasThread &m, int s) {
+    ResumoSerie r;
+    for (int b = 0; b < BALDES_HIST; b++) r.n += m.baldes[s][b].load(memory_order_relaxed);
+    r.soma = m.soma[s].load(memory_order_relaxed);
+    r.maximo = m.maximo[s].load(memory_order_relaxed);
+    if (!r.n) return r;
+    uint64_t *alvos[] = {&r.p50, &r.p90, &r.p99, &r.p999};
+    double fracoes[] = {0.5, 0.9, 0.99, 0.999};
+    uint64_t acumulado = 0;
+    int k = 0;
+    for (int b = 0; b < BALDES_HIST && k < 4; b++) {
+        acumulado += m.baldes[s][b].load(memory_order_relaxed);
+        while (k < 4 && acumulado >= (uint64_t)ceil(fracoes[k] * r.n))
+            *alvos[k++] = min(limiteBalde(b), r.maximo);
+    }
+    return r;
+}
+
+// Memória ocupada pelas estruturas (capacidade alocada, em bytes)
+struct ItemMemoria {
+    const char *nome;
+    size_t bytes;
+};
+
+template <class T>
+size_t bytesDe(const vector<T> &v) {
+    return v.capacity() * sizeof(T);
+}
+
+inline size_t bytesGrafo(const Grafo &g) {
+    return bytesDe(g.inicio) + bytesDe(g.destino) + bytesDe(g.peso) + bytesDe(g.cabeca) +
+           bytesDe(g.bufDestino) + bytesDe(g.bufPeso) + bytesDe(g.bufProx);
+}
+
+inline size_t bytesCacheHospitais() {
+    const CacheHospitais &c = cacheHospitais;
+    size_t bytes = bytesDe(c.entradas) + bytesDe(c.inverso);
+    for (const EntradaCacheHospitais &e : c.entradas)
+        for (const RotaHospital &r : e.rotas) bytes += sizeof r + bytesDe(r.caminho);
+    for (const auto &l : c.inverso) bytes += bytesDe(l);
+    return bytes;
+}
+
+inline vector<ItemMemoria> memoriaIndices() {
+    size_t bytesCidades = cidades.texto.capacity() + bytesDe(cidades.inicio) +
+                          bytesDe(cidades.pos) + bytesDe(cidades.porNome) + bytesDe(hospital.palavras);
+
+    size_t textos = cadastro.textos.blocos.size() * TAM_BLOCO_TEXTO; // blocos grandes: aproximado
+    size_t esp = 0;
+    for (int i = 0; i < QTD_ESPECIALIDADES; i++)
+        esp += bytesDe(indiceEsp.lista[i]) + bytesGrade(indiceEsp.grade[i]);
+
+    return {
+        {"cidades", bytesCidades},
+        {"grafo", bytesGrafo(grafo) + bytesGrafo(grafoReverso)},
+        {"tabela_hospital", bytesDe(tabelaHosp.dist) + bytesDe(tabelaHosp.maisProximo) +
+                            bytesDe(tabelaHosp.proxSalto)},
+        {"hierarquia_contracao", bytesDe(indiceCH.ranking) + bytesDe(indiceCH.ordem) +
+                                 bytesDe(indiceCH.iniSobe) + bytesDe(indiceCH.iniDesce) +
+                                 bytesDe(indiceCH.sobe) + bytesDe(indiceCH.desce) +
+                                 bytesDe(indiceCH.distDesce) + bytesDe(indiceCH.arestaDesce)},
+        {"profissionais", bytesDe(cadastro.registros) + textos},
+        {"arvore_nome", arvoreNome.nos.size() * sizeof(NoB)},
+        {"nomes_normalizados", nomesNormalizados.arvore.nos.size() * sizeof(NoB) +
+                                   nomesNormalizados.textos.blocos.size() * TAM_BLOCO_TEXTO},
+        {"indice_crm", bytesDe(indiceCRM.chaves) + bytesDe(indiceCRM.valores)},
+        {"grade", bytesGrade(grade)},
+        {"alcance", bytesDe(alcance.comp) + bytesDe(alcance.alcanca) +
+                    bytesDe(alcance.membrosInicio) + bytesDe(alcance.membros)},
+        {"cache_hospitais", bytesCacheHospitais()},
+        {"especialidades", esp},
+        {"snapshot_mapeado", snap.ativo ? snap.tamanho : 0},
+    };
+}
+
+inline void metricasImprimir(SaidaBuffer &out) {
+    unique_ptr<MetricasThread> t = metricasTotais();
+    char linha[160];
+    snprintf(linha, sizeof linha, "%-24s %-7s %10s %10s %10s %10s %10s %10s %10s\n",
+             "serie", "unidade", "n", "media", "p50", "p90", "p99", "p99.9", "max");
+    out << linha;
+    for (int s = 0; s < QTD_SERIES; s++) {
+        ResumoSerie r = metricaResumir(*t, s);
+        if (!r.n) continue;
+        snprintf(linha, sizeof linha,
+                 "%-24s %-7s %10llu %10.0f %10llu %10llu %10llu %10llu %10llu\n",
+                 SERIES[s].nome, SERIES[s].unidade, (unsigned long long)r.n,
+                 (double)r.soma / r.n, (unsigned long long)r.p50, (unsigned long long)r.p90,
+                 (unsigned long long)r.p99, (unsigned long long)r.p999,
+                 (unsigned long long)r.maximo);
+        out << linha;
+    }
+    size_t total = 0;
+    out << "\nmemoria (bytes)\n";
+    for (const ItemMemoria &m : memoriaIndices()) {
+        snprintf(linha, sizeof linha, "%-24s %14zu\n", m.nome, m.bytes);
+        out << linha;
+        total += m.bytes;
+    }
+    snprintf(linha, sizeof linha, "%-24s %14zu\n", "total", total);
+    out << linha;
+}
+
+// Mesmo conteúdo em JSON, numa linha
+inline string metricasJSON() {
+    unique_ptr<MetricasThread> t = metricasTotais();
+    string j = "{\"series\":{";
+    bool primeira = true;
+    for (int s = 0; s < QTD_SERIES; s++) {
+        ResumoSerie r = metricaResumir(*t, s);
+        char buf[320];
+        snprintf(buf, sizeof buf,
+                 "%s\"%s\":{\"unidade\":\"%s\",\"n\":%llu,\"soma\":%llu,\"p50\":%llu,"
+                 "\"p90\":%llu,\"p99\":%llu,\"p999\":%llu,\"max\":%llu}",
+                 primeira ? "" : ",", SERIES[s].nome, SERIES[s].unidade,
+                 (unsigned long long)r.n, (unsigned long long)r.soma, (unsigned long long)r.p50,
+                 (unsigned long long)r.p90, (unsigned long long)r.p99,
+                 (unsigned long long)r.p999, (unsigned long long)r.maximo);
+        j += buf;
+        primeira = false;
+    }
+    j += "},\"memoria\":{";
+    size_t total = 0;
+    for (const ItemMemoria &m : memoriaIndices()) {
+        j += "\"" + string(m.nome) + "\":" + to_string(m.bytes) + ",";
+        total += m.bytes;
+    }
+    j += "\"total\":" + to_string(total) + "}}\n";
+    return j;
+}
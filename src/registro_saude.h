@@ -0,0 +1,470 @@
+// Cadastro embutível com leituras concorrentes. O escritor aplica as
+// alterações ao núcleo (um estado por processo) e publica versões imutáveis;
+// os leitores consultam a versão atual sem tomar trava nenhuma. Toda leitura
+// feita fora da thread escritora deve passar pelas funções versao*/registro*
+// abaixo: as do núcleo leem o estado global, que o escritor altera.
+//
+//     RegistroSaude reg;
+//     registroIniciar(reg);
+//     registroCidade(reg, "Centro", true);
+//     registroPublicar(reg);
+//     RotaHospital r = registroRotaHospital(reg, 1);   // de qualquer thread
+#pragma once
+
+#include "nucleo.h"
+
+/* ===========================
+   RECUPERAÇÃO POR ÉPOCAS
+=========================== */
+// Cada thread leitora reserva uma vaga na primeira leitura e, enquanto lê,
+// anuncia nela a época global vigente. Uma versão retirada na época e só é
+// liberada quando todas as vagas ativas anunciam época maior que e: quem
+// entrou depois da retirada já enxerga a versão nova.
+const int MAX_LEITORES = 256;
+
+struct alignas(64) VagaLeitor {
+    atomic<uint64_t> epoca{0};    // 0 = fora de leitura
+    atomic<bool> ocupada{false};
+};
+
+struct DominioEpocas {
+    atomic<uint64_t> epoca{1};
+    VagaLeitor vagas[MAX_LEITORES];
+};
+
+inline DominioEpocas epocas;
+
+// Vaga da thread, devolvida quando a thread termina
+struct VagaThread {
+    int vaga = -1;
+    int profundidade = 0;         // leituras aninhadas na mesma thread
+    ~VagaThread() {
+        if (vaga >= 0) epocas.vagas[vaga].ocupada.store(false, memory_order_release);
+    }
+};
+
+inline thread_local VagaThread vagaThread;
+
+inline int epocaReservarVaga() {
+    for (;;) {
+        for (int i = 0; i < MAX_LEITORES; i++) {
+            bool livre = false;
+            if (!epocas.vagas[i].ocupada.load(memory_order_relaxed) &&
+                epocas.vagas[i].ocupada.compare_exchange_strong(livre, true))
+                return i;
+        }
+        this_thread::yield(); // mais threads leitoras vivas do que vagas
+    }
+}
+
+inline void epocaEntrar() {
+    VagaThread &t = vagaThread;
+    if (t.profundidade++ > 0) return;
+    if (t.vaga < 0) t.vaga = epocaReservarVaga();
+    // seq_cst: o anúncio fica visível ao escritor antes da leitura do ponteiro
+    epocas.vagas[t.vaga].epoca.store(epocas.epoca.load());
+}
+
+inline void epocaSair() {
+    VagaThread &t = vagaThread;
+    if (--t.profundidade > 0) return;
+    epocas.vagas[t.vaga].epoca.store(0, memory_order_release);
+}
+
+// Menor época anunciada por um leitor ativo (UINT64_MAX se não há nenhum)
+inline uint64_t epocaMinimaAtiva() {
+    uint64_t m = UINT64_MAX;
+    for (int i = 0; i < MAX_LEITORES; i++) {
+        uint64_t e = epocas.vagas[i].epoca.load();
+        if (e && e < m) m = e;
+    }
+    return m;
+}
+
+/* ===========================
+   VERSÕES PUBLICADAS
+=========================== */
+// Uma versão não muda depois de publicada. A parte que não foi alterada desde
+// a publicação anterior (mapa ou profissionais) é compartilhada, não copiada.
+// A tabela de hospital mais próximo vai junto com o mapa: a rota sai em
+// O(tamanho do caminho), sem Dijkstra no caminho da leitura.
+//
+// O cache de hospitais alternativos também acompanha o mapa e é a única
+// parte que muda depois da publicação: os leitores o preenchem sob a trava
+// dele. Ao publicar um mapa novo, o escritor leva o cache da versão anterior
+// (a versão velha fica com um vazio) e invalida as entradas atingidas pelas
+// vias incluídas no intervalo, como faz cacheHospitaisNovaVia no estado em
+// memória.
+struct CacheVersao {
+    mutex trava;
+    CacheHospitais c;
+};
+
+struct VersaoRegistro {
+    uint64_t numero = 0;
+    uint64_t lsn = 0;                          // último cadastro incluído
+    shared_ptr<const ImagemMapa> mapa;
+    shared_ptr<const TabelaHospital> tabela;
+    shared_ptr<const IndiceAlcance> alcance;   // condensado (regiões exatas)
+    shared_ptr<CacheVersao> cacheHospitais;
+    shared_ptr<const ImagemProfissionais> profs;
+    Snapshot visao;                            // aponta para mapa e profs
+};
+
+// O núcleo guarda o estado em globais, então só pode existir um
+// RegistroSaude por vez no processo; criar um segundo aborta em vez de deixar
+// os dois publicarem o mesmo estado
+inline atomic<bool> registroExiste{false};
+
+struct RegistroSaude {
+    atomic<const VersaoRegistro*> atual{NULL};
+    mutex escrita;                             // serializa os escritores
+    bool mapaAlterado = false, profsAlterados = false;
+    vector<int> origensNovas;                  // vias desde o último mapa publicado
+    uint64_t publicadas = 0;
+    vector<pair<uint64_t, const VersaoRegistro*>> retiradas; // (época, versão)
+
+    RegistroSaude() {
+        if (registroExiste.exchange(true)) {
+            cerr << "RegistroSaude: ja existe outra instancia neste processo\n";
+            abort();
+        }
+    }
+    ~RegistroSaude() { registroExiste.store(false); }
+    RegistroSaude(const RegistroSaude&) = delete;
+    RegistroSaude& operator=(const RegistroSaude&) = delete;
+};
+
+// Libera as versões retiradas que nenhum leitor pode mais estar usando
+inline void registroColetar(RegistroSaude &r) {
+    uint64_t minima = epocaMinimaAtiva();
+    size_t j = 0;
+    for (auto &ret : r.retiradas) {
+        if (ret.first < minima) delete ret.second;
+        else r.retiradas[j++] = ret;
+    }
+    r.retiradas.resize(j);
+}
+
+// Chamada com a trava de escrita
+inline void registroPublicarTravado(RegistroSaude &r) {
+    Cronometro cron(MET_PUBLICAR);
+    const VersaoRegistro *velha = r.atual.load();
+    VersaoRegistro *v = new VersaoRegistro;
+    v->numero = ++r.publicadas;
+    v->lsn = lsnAtual;
+
+    if (!velha || r.mapaAlterado) {
+        auto m = make_shared<ImagemMapa>();
+        imagemMapaMontar(*m);
+        auto t = make_shared<TabelaHospital>();
+        if (tabelaHosp.ativa) *t = tabelaHosp;
+        else tabelaConstruir(*t);
+        auto c = make_shared<CacheVersao>();
+        if (velha) {
+            lock_guard<mutex> trava(velha->cacheHospitais->trava);
+            c->c = move(velha->cacheHospitais->c);
+            velha->cacheHospitais->c = CacheHospitais();
+        }
+        for (int o : r.origensNovas) cacheHospitaisNovaVia(c->c, o);
+        r.origensNovas.clear();
+        alcanceCondensar(alcance);
+        v->mapa = m;
+        v->tabela = t;
+        v->alcance = make_shared<IndiceAlcance>(alcance);
+        v->cacheHospitais = c;
+    } else {
+        v->mapa = velha->mapa;
+        v->tabela = velha->tabela;
+        v->alcance = velha->alcance;
+        v->cacheHospitais = velha->cacheHospitais;
+    }
+    if (!velha || r.profsAlterados) {
+        auto p = make_shared<ImagemProfissionais>();
+        imagemProfissionaisMontar(*p);
+        imagemNomesNormalizadosMontar(*p);
+        v->profs = p;
+    } else {
+        v->profs = velha->profs;
+    }
+    visaoMapa(v->visao, *v->mapa);
+    visaoProfissionais(v->visao, *v->profs);
+    v->visao.ativo = true;
+    r.mapaAlterado = r.profsAlterados = false;
+
+    r.atual.store(v);
+    if (velha) r.retiradas.push_back({epocas.epoca.fetch_add(1), velha});
+    registroColetar(r);
+}
+
+/* --- Escrita --- */
+// Carrega um snapshot mapeado, se houver, e publica a primeira versão
+inline void registroIniciar(RegistroSaude &r) {
+    lock_guard<mutex> trava(r.escrita);
+    garantirMaterializado();
+    registroPublicarTravado(r);
+}
+
+// Os cadastros passam pelo WAL (se aberto) como no menu e só ficam visíveis
+// aos leitores no próximo registroPublicar, que pode agrupar vários deles
+
+// Retorna o ID da nova cidade, ou -1 se o limite foi atingido ou o log falhou
+inline int registroCidade(RegistroSaude &r, const string &nome, bool temHospital,
+                          Coord pos = SEM_POSICAO) {
+    lock_guard<mutex> trava(r.escrita);
+    if (!cidadeCabe(nome) || !logCidade(nome, temHospital, pos)) return -1;
+    r.mapaAlterado = true;
+    return cidadeInserir(nome, temHospital, pos);
+}
+
+inline bool registroVia(RegistroSaude &r, int o, int d, int minutos) {
+    lock_guard<mutex> trava(r.escrita);
+    if (o < 1 || d < 1 || o > qtdCidades || d > qtdCidades || minutos < 1) return false;
+    if (!logVia(o, d, minutos)) return false;
+    viaInserir(o, d, minutos);
+    r.origensNovas.push_back(o);
+    r.mapaAlterado = true;
+    return true;
+}
+
+// SEM_ID se o nome ou o CRM já existem, ou se o log falhou
+inline IdProf registroProfissional(RegistroSaude &r, string_view nome, IdEsp esp,
+                                   int crm, Coord pos) {
+    lock_guard<mutex> trava(r.escrita);
+    if (esp >= QTD_ESPECIALIDADES || crmExiste(crm) || arvoreBuscar(arvoreNome, nome) != SEM_ID)
+        return SEM_ID;
+    if (!logProfissional(nome, esp, crm, pos)) return SEM_ID;
+    r.profsAlterados = true;
+    return profissionalInserir(nome, esp, crm, pos);
+}
+
+// Torna visíveis os cadastros pendentes; retorna o número da versão atual
+inline uint64_t registroPublicar(RegistroSaude &r) {
+    lock_guard<mutex> trava(r.escrita);
+    if (r.mapaAlterado || r.profsAlterados) registroPublicarTravado(r);
+    else registroColetar(r);
+    return r.atual.load()->numero;
+}
+
+// Só com todos os leitores encerrados
+inline void registroEncerrar(RegistroSaude &r) {
+    lock_guard<mutex> trava(r.escrita);
+    for (auto &ret : r.retiradas) delete ret.second;
+    r.retiradas.clear();
+    delete r.atual.exchange(NULL);
+}
+
+/* --- Leitura --- */
+// Fixa a versão atual enquanto existir; string_view obtidos dela valem até
+// a guarda sair de escopo. Não bloqueia e não é bloqueada pelo escritor.
+struct LeituraRegistro {
+    const VersaoRegistro *v;
+
+    explicit LeituraRegistro(const RegistroSaude &r) {
+        epocaEntrar();
+        v = r.atual.load();
+    }
+    ~LeituraRegistro() { epocaSair(); }
+    LeituraRegistro(const LeituraRegistro&) = delete;
+    LeituraRegistro& operator=(const LeituraRegistro&) = delete;
+};
+
+inline int versaoQtdCidades(const VersaoRegistro &v) {
+    return v.visao.qtdCidades;
+}
+
+inline string_view versaoNomeCidade(const VersaoRegistro &v, int id) {
+    return snapNomeCidade(v.visao, id);
+}
+
+inline RotaHospital versaoRotaHospital(const VersaoRegistro &v, int inicio) {
+    Cronometro cron(MET_ROTA_HOSPITAL);
+    if (inicio < 1 || inicio > v.visao.qtdCidades) return RotaHospital();
+    return rotaTabela(*v.tabela, inicio);
+}
+
+// Os k hospitais mais próximos, como kHospitais, no mapa da versão
+inline vector<RotaHospital> versaoKHospitais(const VersaoRegistro &v, int inicio, int k, bool trechos) {
+    Cronometro cron(MET_K_HOSPITAIS);
+    // Sem hospital alcançável: a tabela publicada responde sem busca
+    if (k < 1 || inicio < 1 || inicio > v.visao.qtdCidades || v.tabela->dist[inicio] == DIST_INF)
+        return {};
+    CacheVersao &cv = *v.cacheHospitais;
+    size_t chave = chaveCacheHospitais(inicio, trechos);
+    vector<RotaHospital> res;
+    {
+        lock_guard<mutex> trava(cv.trava);
+        if (cacheHospitaisBuscar(cv.c, chave, k, res)) return res;
+    }
+    // A busca roda fora da trava; duas threads podem calcular a mesma
+    // entrada, e a última a guardar fica
+    static thread_local vector<int> bola;
+    bola.clear();
+    res = kHospitaisDijkstra(v.visao.grafo, v.visao.hospital, v.visao.qtdCidades, inicio, k, trechos, &bola);
+    lock_guard<mutex> trava(cv.trava);
+    cacheHospitaisGuardar(cv.c, chave, k, v.visao.qtdCidades, res, bola);
+    return res;
+}
+
+inline vector<Vizinho> versaoRaio(const VersaoRegistro &v, Coord c, int raio) {
+    return gradeRaio(v.visao.grade, c, raio);
+}
+
+inline vector<Vizinho> versaoKProximos(const VersaoRegistro &v, Coord c, int k) {
+    return gradeKProximos(v.visao.grade, c, k);
+}
+
+inline vector<Vizinho> versaoKProximosEsp(const VersaoRegistro &v, IdEsp esp, Coord c, int k) {
+    return snapKProximosEsp(v.visao, esp, c, k);
+}
+
+inline uint32_t versaoQtdProfissionais(const VersaoRegistro &v) {
+    return v.visao.qtdProfs;
+}
+
+inline Profissional versaoProfissional(const VersaoRegistro &v, IdProf id) {
+    const RegistroSnapshot &r = v.visao.profs[id];
+    return {snapNomeProf(v.visao, id), r.especialidade, r.crm, {r.x, r.y}};
+}
+
+inline IdProf versaoBuscarCRM(const VersaoRegistro &v, int crm) {
+    const Snapshot &s = v.visao;
+    return crmSondar(s.crmChaves, s.crmValores, s.crmCapacidade, crm);
+}
+
+// Busca binária na ordem alfabética publicada
+inline IdProf versaoBuscarNome(const VersaoRegistro &v, string_view nome) {
+    Cronometro cron(MET_BUSCA_NOME);
+    const Snapshot &s = v.visao;
+    const IdProf *fim = s.ordemNome + s.qtdProfs;
+    const IdProf *it = lower_bound(s.ordemNome, fim, nome, [&](IdProf id, string_view n) {
+        return snapNomeProf(s, id) < n;
+    });
+    return (it != fim && snapNomeProf(s, *it) == nome) ? *it : SEM_ID;
+}
+
+// Como buscarPrefixo e buscarAproximado, sobre as chaves normalizadas publicadas
+inline vector<IdProf> versaoBuscarPrefixo(const VersaoRegistro &v, string_view prefixo, size_t n) {
+    Cronometro cron(MET_BUSCA_PREFIXO);
+    string p;
+    normalizarNome(prefixo, p);
+    return buscaPrefixo(cursorNomesNormalizados(*v.profs, p), p, n);
+}
+
+inline vector<NomeAproximado> versaoBuscarAproximado(const VersaoRegistro &v, string_view nome,
+                                                     int maxDist, size_t n) {
+    Cronometro cron(MET_BUSCA_APROXIMADA);
+    return buscaAproximada(cursorNomesNormalizados(*v.profs, string_view()), nome, maxDist, n);
+}
+
+// Como paginaPorNome: até n nomes maiores que 'apos' ("" = início)
+inline vector<IdProf> versaoPaginaPorNome(const VersaoRegistro &v, string_view apos, size_t n) {
+    Cronometro cron(MET_PAGINA);
+    const Snapshot &s = v.visao;
+    const IdProf *it = s.ordemNome, *fim = s.ordemNome + s.qtdProfs;
+    if (!apos.empty())
+        it = upper_bound(it, fim, apos, [&](string_view a, IdProf id) { return a < snapNomeProf(s, id); });
+    return vector<IdProf>(it, it + min<size_t>(n, fim - it));
+}
+
+// Como paginaEspecialidade: até n IDs maiores que 'apos' (SEM_ID = início)
+inline vector<IdProf> versaoPaginaEspecialidade(const VersaoRegistro &v, IdEsp esp, IdProf apos,
+                                                size_t n) {
+    Cronometro cron(MET_PAGINA);
+    if (esp >= QTD_ESPECIALIDADES) return {};
+    const Snapshot &s = v.visao;
+    const IdProf *it = s.espIds + s.espInicio[esp], *fim = s.espIds + s.espInicio[esp + 1];
+    if (apos != SEM_ID) it = upper_bound(it, fim, apos);
+    return vector<IdProf>(it, it + min<size_t>(n, fim - it));
+}
+
+inline vector<vector<int>> versaoRegioesSemHospital(const VersaoRegistro &v) {
+    return regioesSemHospital(*v.alcance);
+}
+
+// Atalhos de uma consulta só: o resultado não depende da versão continuar viva
+inline RotaHospital registroRotaHospital(const RegistroSaude &r, int inicio) {
+    LeituraRegistro l(r);
+    return versaoRotaHospital(*l.v, inicio);
+}
+
+inline vector<RotaHospital> registroKHospitais(const RegistroSaude &r, int inicio, int k,
+                                              bool trechos = false) {
+    LeituraRegistro l(r);
+    return versaoKHospitais(*l.v, inicio, k, trechos);
+}
+
+inline vector<IdProf> registroBuscarPrefixo(const RegistroSaude &r, string_view prefixo, size_t n) {
+    LeituraRegistro l(r);
+    return versaoBuscarPrefixo(*l.v, prefixo, n);
+}
+
+inline vector<NomeAproximado> registroBuscarAproximado(const RegistroSaude &r, string_view nome,
+                                                       int maxDist, size_t n) {
+    LeituraRegistro l(r);
+    return versaoBuscarAproximado(*l.v, nome, maxDist, n);
+}
+
+inline vector<IdProf> registroPaginaPorNome(const RegistroSaude &r, string_view apos, size_t n) {
+    LeituraRegistro l(r);
+    return versaoPaginaPorNome(*l.v, apos, n);
+}
+
+inline vector<IdProf> registroPaginaEspecialidade(const RegistroSaude &r, IdEsp esp, IdProf apos,
+                                                  size_t n) {
+    LeituraRegistro l(r);
+    return versaoPaginaEspecialidade(*l.v, esp, apos, n);
+}
+
+inline vector<vector<int>> registroRegioesSemHospital(const RegistroSaude &r) {
+    LeituraRegistro l(r);
+    return versaoRegioesSemHospital(*l.v);
+}
+
+inline vector<Vizinho> registroRaio(const RegistroSaude &r, Coord c, int raio) {
+    LeituraRegistro l(r);
+    return versaoRaio(*l.v, c, raio);
+}
+
+inline vector<Vizinho> registroKProximos(const RegistroSaude &r, Coord c, int k) {
+    LeituraRegistro l(r);
+    return versaoKProximos(*l.v, c, k);
+}
+
+inline vector<Vizinho> registroKProximosEsp(const RegistroSaude &r, IdEsp esp, Coord c, int k) {
+    LeituraRegistro l(r);
+    return versaoKProximosEsp(*l.v, esp, c, k);
+}
+
+/* ===========================
+   CONSULTAS EM LOTE
+=========================== */
+// O lote inteiro lê a mesma versão, fixada por quem chama, e é distribuído
+// entre as threads do pool. Os resultados saem na ordem da entrada.
+inline vector<RotaHospital> registroLoteRotas(const RegistroSaude &r, const vector<int> &inicios,
+                                              PoolTrabalho &p = poolLote()) {
+    LeituraRegistro l(r);
+    const VersaoRegistro &v = *l.v;
+    vector<RotaHospital> res(inicios.size());
+    poolExecutar(p, inicios.size(), [&](size_t i) { res[i] = versaoRotaHospital(v, inicios[i]); });
+    return res;
+}
+
+inline vector<vector<Vizinho>> registroLoteRaio(const RegistroSaude &r, const vector<Coord> &centros,
+                                                int raio, PoolTrabalho &p = poolLote()) {
+    LeituraRegistro l(r);
+    const VersaoRegistro &v = *l.v;
+    vector<vector<Vizinho>> res(centros.size());
+    poolExecutar(p, centros.size(), [&](size_t i) { res[i] = versaoRaio(v, centros[i], raio); });
+    return res;
+}
+
+inline vector<vector<Vizinho>> registroLoteKProximos(const RegistroSaude &r,
+                                                     const vector<Coord> &centros, int k,
+                                                     PoolTrabalho &p = poolLote()) {
+    LeituraRegistro l(r);
+    const VersaoRegistro &v = *l.v;
+    vector<vector<Vizinho>> res(centros.size());
+    poolExecutar(p, centros.size(), [&](size_t i) { res[i] = versaoKProximos(v, centros[i], k); });
+    return res;
+}
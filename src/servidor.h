@@ -0,0 +1,598 @@
+#pragma once
+// Modo servidor: requisições em linhas, sem prompts, sobre stdin/stdout ou um
+// socket Unix local. Usa o mesmo estado global do menu, numa única thread.
+#include "nucleo.h"
+#include <csignal>
+#include <unordered_set>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* ===========================
+        PROTOCOLO
+=========================== */
+// Uma requisição por linha, campos separados por TAB (ou por espaços, se a
+// linha não tiver TAB; nomes com espaço exigem TAB). O comando não diferencia
+// maiúsculas e linhas em branco são ignoradas. Cada requisição recebe uma
+// resposta, na mesma ordem:
+//   OK[\t<campos>]     sucesso
+//   ERR\t<motivo>      erro; a conexão continua
+// Listas respondem "OK\t<n>" seguido de n linhas.
+//
+//   CIDADE nome hospital(0|1) [x y] -> OK id
+//   VIA origem destino minutos  -> OK
+//   PROF nome esp crm x y       -> OK id           (esp: 1..8 ou o nome)
+//   ROTA cidade                 -> OK hospital custo id,id,...  ou  OK -1
+//                                  (cidade: ID ou nome)
+//   KHOSP cidade k [tempo|trechos] -> lista dos k hospitais mais próximos:
+//                                  hospital custo id,id,...
+//   RAIO x y r | KNN x y k [esp] -> lista de: id nome esp distancia
+//   NOME nome | CRM crm         -> OK id nome esp crm x y
+//   PREFIXO texto n             -> lista de: id nome esp crm x y, em ordem
+//                                  de nome (sem diferenciar maiúsculas/acentos)
+//   APROX nome dist n           -> lista de: distancia id nome esp crm x y
+//                                  (dist: 0..3 edições), mais próximos antes
+//   LISTA n [apos_nome]         -> lista de: id nome esp crm x y
+//   ESP esp n [cursor]          -> idem; cursor = último id da página anterior
+//   MODO dijkstra|tabela|ch|trechos -> OK   (em trechos, o custo da ROTA
+//                                  é o número de vias, não minutos; MODO ch
+//                                  reconstrói o índice CH, e depois de um
+//                                  CIDADE ou VIA a ROTA usa Dijkstra até o
+//                                  próximo MODO ch)
+//   ESCALA                      -> lista de: profissional hospital distancia
+//                                  (hospital mais próximo; -1 se nenhum)
+//   EQUIPES raio                -> lista de: hospital qtd id,id,... (os
+//                                  profissionais a até o raio, por distância)
+//   REGIOES                     -> lista de regiões sem acesso a hospital:
+//                                  qtd_cidades id,id,...
+//   STATS                       -> OK json
+//   SAIR                        -> OK e fecha a conexão
+//
+// O cliente pode enviar muitas linhas sem esperar as respostas (pipelining).
+// O laço de eventos executa todas as linhas completas já recebidas e devolve
+// as respostas juntas, num write só. Com --fsync sempre, cadastros seguidos
+// vão para o log e dividem um fsync, mas só são aplicados depois dele: antes
+// da próxima consulta e no fim do lote. Nenhuma linha, nem do mesmo lote, vê
+// um cadastro que ainda não está em disco. Se o write ou o fsync do log
+// falhar, cada cadastro pendente recebe "ERR\tfalha ao gravar o log" no lugar
+// do OK e não é aplicado; as demais respostas ficam como estão, e daí em
+// diante todo cadastro recebe esse erro.
+const size_t TAM_RECEBER = 64 * 1024;
+const size_t LIMITE_LINHA = 1 << 20;     // linha sem '\n' maior que isso fecha a conexão
+const size_t LIMITE_RESPOSTA = 4 << 20;  // acima disso para de ler (contrapressão)
+const char *const ERRO_LOG = "falha ao gravar o log";
+
+struct ConexaoServidor {
+    int entrada, saida;      // o mesmo fd no socket; 0 e 1 no modo stdin
+    string recebido, resposta;
+    size_t lido = 0;         // início da próxima linha em recebido
+    size_t enviado = 0;      // bytes de resposta já escritos
+    bool fimEntrada = false, fechar = false;
+    int pollEntrada = -1, pollSaida = -1;
+
+    ConexaoServidor(int entrada, int saida) : entrada(entrada), saida(saida) {}
+};
+
+inline volatile sig_atomic_t servidorParar = 0;
+
+inline void dividirCampos(string_view linha, vector<string_view> &campos) {
+    campos.clear();
+    if (!linha.empty() && linha.back() == '\r') linha.remove_suffix(1);
+    if (linha.find('\t') != string_view::npos) {
+        for (size_t ini = 0;;) {
+            size_t fim = linha.find('\t', ini);
+            campos.push_back(linha.substr(ini, fim == string_view::npos ? fim : fim - ini));
+            if (fim == string_view::npos) break;
+            ini = fim + 1;
+        }
+        return;
+    }
+    size_t i = 0;
+    while (i < linha.size()) {
+        if (linha[i] == ' ') {
+            i++;
+            continue;
+        }
+        size_t fim = min(linha.find(' ', i), linha.size());
+        campos.push_back(linha.substr(i, fim - i));
+        i = fim;
+    }
+}
+
+inline void respostaProfissional(SaidaBuffer &out, IdProf id) {
+    const Profissional &p = prof(id);
+    out << id << '\t' << p.nome << '\t' << ESPECIALIDADES[p.especialidade] << '\t'
+        << p.crm << '\t' << p.pos.x << '\t' << p.pos.y << '\n';
+}
+
+inline void respostaLista(SaidaBuffer &out, const vector<IdProf> &ids) {
+    out << "OK\t" << ids.size() << '\n';
+    for (IdProf id : ids) respostaProfissional(out, id);
+}
+
+// Serve para a grade em memória e para a do snapshot mapeado
+inline void respostaVizinhos(SaidaBuffer &out, const vector<Vizinho> &res) {
+    out << "OK\t" << res.size() << '\n';
+    for (const Vizinho &v : res) {
+        out << v.second << '\t' << nomeProfDe(v.second) << '\t'
+            << ESPECIALIDADES[espDe(v.second)] << '\t' << sqrt((double)v.first) << '\n';
+    }
+}
+
+/* ===========================
+        CADASTROS PENDENTES
+=========================== */
+// Cadastros já anexados ao log e ainda não aplicados. Os seguintes são
+// validados contra o estado somado a estes: IDs de cidades e profissionais
+// que ainda vão existir, nomes e CRMs já tomados.
+struct CadastroPendente {
+    TipoRegistroLog tipo;
+    string nome;
+    bool hospital = false;
+    IdEsp esp = 0;
+    int a = 0, b = 0, d = 0;     // VIA: origem, destino, minutos; PROF: a = CRM
+    Coord pos = SEM_POSICAO;
+    size_t ini = 0, fim = 0;     // o OK deste cadastro em con.resposta
+};
+
+struct CadastrosPendentes {
+    vector<CadastroPendente> lista;
+    int cidades = 0;
+    size_t bytesNomesCidades = 0;
+    size_t profs = 0;
+    unordered_set<string> nomesProfs;
+    unordered_set<int> crms;
+};
+
+// No modo sempre os cadastros esperam o fsync antes de serem aplicados; nos
+// outros são aplicados logo depois de anexados
+inline bool servidorAdiarCadastros() {
+    return wal.ativo && wal.modo == FSYNC_SEMPRE;
+}
+
+inline void pendenteAnexar(CadastrosPendentes &p, CadastroPendente c, size_t ini, size_t fim) {
+    if (c.tipo == LOG_CIDADE) {
+        p.cidades++;
+        p.bytesNomesCidades += c.nome.size();
+    } else if (c.tipo == LOG_PROFISSIONAL) {
+        p.profs++;
+        p.nomesProfs.insert(c.nome);
+        p.crms.insert(c.a);
+    }
+    c.ini = ini;
+    c.fim = fim;
+    p.lista.push_back(move(c));
+}
+
+// Espera o fsync (modo sempre) e aplica os pendentes, na ordem. Se o log
+// falhou, nenhum é aplicado e o OK de cada um em resposta vira o erro.
+inline void pendentesConfirmar(CadastrosPendentes &p, string &resposta) {
+    if (p.lista.empty()) return;
+    if (!servidorAdiarCadastros() || logAguardarDuravel()) {
+        for (const CadastroPendente &c : p.lista) {
+            if (c.tipo == LOG_CIDADE) cidadeInserir(c.nome, c.hospital, c.pos);
+            else if (c.tipo == LOG_VIA) viaInserir(c.a, c.b, c.d);
+            else profissionalInserir(c.nome, c.esp, c.a, c.pos);
+        }
+    } else {
+        string resto;
+        size_t de = p.lista[0].ini;
+        for (const CadastroPendente &c : p.lista) {
+            resto.append(resposta, de, c.ini - de);
+            resto.append("ERR\t").append(ERRO_LOG).append("\n");
+            de = c.fim;
+        }
+        resto.append(resposta, de, string::npos);
+        resposta.resize(p.lista[0].ini);
+        resposta += resto;
+        lsnAtual -= p.lista.size(); // anexados, mas nunca aplicados
+    }
+    p.lista.clear();
+    p.cidades = 0;
+    p.bytesNomesCidades = 0;
+    p.profs = 0;
+    p.nomesProfs.clear();
+    p.crms.clear();
+}
+
+// Executa uma requisição e anexa a resposta em out. Cadastros passam por
+// 'pendentes'; qualquer outro comando antes confirma os que houver. Retorna
+// false para SAIR.
+inline bool servidorExecutar(const vector<string_view> &c, SaidaBuffer &out, CadastrosPendentes &pendentes) {
+    Cronometro cron(MET_REQUISICAO);
+    char cmd[8];
+    size_t n = min(c[0].size(), sizeof cmd);
+    for (size_t i = 0; i < n; i++) cmd[i] = (char)toupper((unsigned char)c[0][i]);
+    string_view op(cmd, c[0].size() <= sizeof cmd ? n : 0);
+    size_t args = c.size() - 1;
+    auto erro = [&](const char *motivo) {
+        out << "ERR\t" << motivo << '\n';
+        return true;
+    };
+
+    bool ehCadastro = op == "CIDADE" || op == "VIA" || op == "PROF";
+    if (!ehCadastro) pendentesConfirmar(pendentes, out.buf);
+    // Rota (Dijkstra) e proximidade leem direto do snapshot mapeado, como no menu
+    if (op != "ROTA" && op != "KHOSP" && op != "RAIO" && op != "KNN" && op != "STATS" && op != "SAIR")
+        garantirMaterializado();
+
+    int a, b, d;
+    size_t ini = out.buf.size();
+    if (op == "CIDADE") {
+        Coord pos = SEM_POSICAO;
+        if ((args != 2 && args != 4) || c[1].empty() || !lerInt(c[2], a) || (a != 0 && a != 1) ||
+            (args == 4 && (!lerInt(c[3], pos.x) || !lerInt(c[4], pos.y))))
+            return erro("uso: CIDADE nome hospital(0|1) [x y]");
+        if (qtdCidades + pendentes.cidades >= MAX_CIDADES ||
+            cidades.texto.size() + pendentes.bytesNomesCidades + c[1].size() > UINT32_MAX)
+            return erro("limite de cidades atingido");
+        string nome(c[1]);
+        if (!logCidade(nome, a == 1, pos)) return erro(ERRO_LOG);
+        out << "OK\t" << qtdCidades + pendentes.cidades + 1 << '\n';
+        CadastroPendente p{LOG_CIDADE, move(nome)};
+        p.hospital = a == 1;
+        p.pos = pos;
+        pendenteAnexar(pendentes, move(p), ini, out.buf.size());
+    } else if (op == "VIA") {
+        if (args != 3 || !lerInt(c[1], a) || !lerInt(c[2], b) || !lerInt(c[3], d))
+            return erro("uso: VIA origem destino minutos");
+        int n = qtdCidades + pendentes.cidades;
+        if (a < 1 || b < 1 || a > n || b > n) return erro("cidade invalida");
+        if (d < 1) return erro("o tempo deve ser positivo");
+        if (!logVia(a, b, d)) return erro(ERRO_LOG);
+        out << "OK\n";
+        CadastroPendente p{LOG_VIA, ""};
+        p.a = a;
+        p.b = b;
+        p.d = d;
+        pendenteAnexar(pendentes, move(p), ini, out.buf.size());
+    } else if (op == "PROF") {
+        IdEsp esp;
+        Coord pos;
+        if (args != 5 || c[1].empty() || !lerEspecialidade(c[2], esp) || !lerInt(c[3], a) ||
+            !lerInt(c[4], pos.x) || !lerInt(c[5], pos.y))
+            return erro("uso: PROF nome especialidade crm x y");
+        string nome(c[1]);
+        if (arvoreBuscar(arvoreNome, nome) != SEM_ID || pendentes.nomesProfs.count(nome))
+            return erro("nome ja cadastrado");
+        if (crmExiste(a) || pendentes.crms.count(a)) return erro("CRM ja cadastrado");
+        if (!logProfissional(nome, esp, a, pos)) return erro(ERRO_LOG);
+        out << "OK\t" << cadastro.registros.size() + pendentes.profs << '\n';
+        CadastroPendente p{LOG_PROFISSIONAL, move(nome)};
+        p.esp = esp;
+        p.a = a;
+        p.pos = pos;
+        pendenteAnexar(pendentes, move(p), ini, out.buf.size());
+    } else if (op == "ROTA") {
+        if (args != 1) return erro("uso: ROTA cidade");
+        if (!lerInt(c[1], a)) {
+            garantirMaterializado(); // o hash de nomes só existe em memória
+            if ((a = cidadeBuscar(c[1])) == -1) return erro("cidade nao encontrada");
+        }
+        if (a < 1 || a > totalCidades()) return erro("cidade invalida");
+        RotaHospital r = rotaHospital(a);
+        if (r.hospital == -1) {
+            out << "OK\t-1\n";
+            return true;
+        }
+        out << "OK\t" << r.hospital << '\t' << r.custo << '\t';
+        for (size_t i = 0; i < r.caminho.size(); i++) out << (i ? "," : "") << r.caminho[i];
+        out << '\n';
+    } else if (op == "KHOSP") {
+        bool trechos = args == 3 && c[3] == "trechos";
+        if (args < 2 || args > 3 || !lerInt(c[2], b) || b < 1 ||
+            (args == 3 && !trechos && c[3] != "tempo"))
+            return erro("uso: KHOSP cidade k [tempo|trechos]");
+        if (!lerInt(c[1], a)) {
+            garantirMaterializado();
+            if ((a = cidadeBuscar(c[1])) == -1) return erro("cidade nao encontrada");
+        }
+        if (a < 1 || a > totalCidades()) return erro("cidade invalida");
+        vector<RotaHospital> rotas = kHospitais(a, b, trechos);
+        out << "OK\t" << rotas.size() << '\n';
+        for (const RotaHospital &r : rotas) {
+            out << r.hospital << '\t' << r.custo << '\t';
+            for (size_t i = 0; i < r.caminho.size(); i++) out << (i ? "," : "") << r.caminho[i];
+            out << '\n';
+        }
+    } else if (op == "RAIO" || op == "KNN") {
+        Coord pos;
+        IdEsp esp;
+        bool filtrar = op == "KNN" && args == 4;
+        if ((args != 3 && !filtrar) || !lerInt(c[1], pos.x) || !lerInt(c[2], pos.y) ||
+            !lerInt(c[3], a) || (filtrar && !lerEspecialidade(c[4], esp)))
+            return erro(op == "RAIO" ? "uso: RAIO x y raio" : "uso: KNN x y k [especialidade]");
+        if (op == "RAIO") {
+            if (a < 0) return erro("raio invalido");
+            respostaVizinhos(out, snap.ativo ? gradeRaio(snap.grade, pos, a) : gradeRaio(grade, pos, a));
+        } else if (a < 1) {
+            return erro("quantidade invalida");
+        } else if (filtrar) {
+            respostaVizinhos(out, kProximosEspecialidade(esp, pos, a));
+        } else {
+            respostaVizinhos(out, snap.ativo ? gradeKProximos(snap.grade, pos, a)
+                                             : gradeKProximos(grade, pos, a));
+        }
+    } else if (op == "NOME" || op == "CRM") {
+        IdProf id;
+        if (op == "NOME") {
+            if (args != 1) return erro("uso: NOME nome");
+            id = arvoreBuscar(arvoreNome, c[1]);
+        } else {
+            if (args != 1 || !lerInt(c[1], a)) return erro("uso: CRM crm");
+            id = crmBuscar(indiceCRM, a);
+        }
+        if (id == SEM_ID) return erro("profissional nao encontrado");
+        out << "OK\t";
+        respostaProfissional(out, id);
+    } else if (op == "PREFIXO") {
+        if (args != 2 || !lerInt(c[2], a) || a < 1) return erro("uso: PREFIXO texto n");
+        respostaLista(out, buscarPrefixo(c[1], a));
+    } else if (op == "APROX") {
+        if (args != 3 || !lerInt(c[2], d) || d < 0 || d > MAX_DIST_EDICAO || !lerInt(c[3], a) || a < 1)
+            return erro("uso: APROX nome dist(0..3) n");
+        vector<NomeAproximado> res = buscarAproximado(c[1], d, a);
+        out << "OK\t" << res.size() << '\n';
+        for (const NomeAproximado &r : res) {
+            out << r.distancia << '\t';
+            respostaProfissional(out, r.id);
+        }
+    } else if (op == "LISTA") {
+        if (args < 1 || args > 2 || !lerInt(c[1], a) || a < 1) return erro("uso: LISTA n [apos_nome]");
+        respostaLista(out, paginaPorNome(arvoreNome, args == 2 ? c[2] : string_view(), a));
+    } else if (op == "ESP") {
+        IdEsp esp;
+        if (args < 2 || args > 3 || !lerEspecialidade(c[1], esp) || !lerInt(c[2], a) || a < 1 ||
+            (args == 3 && !lerInt(c[3], b)))
+            return erro("uso: ESP especialidade n [cursor]");
+        IdProf cursor = (args == 3 && b >= 0) ? (IdProf)b : SEM_ID;
+        respostaLista(out, paginaEspecialidade(indiceEsp, esp, cursor, a));
+    } else if (op == "MODO") {
+        if (args != 1) return erro("uso: MODO dijkstra|tabela|ch|trechos");
+        if (c[1] == "dijkstra") modoHospitalDefinir(MODO_DIJKSTRA);
+        else if (c[1] == "tabela") modoHospitalDefinir(MODO_TABELA);
+        else if (c[1] == "ch") modoHospitalDefinir(MODO_CH);
+        else if (c[1] == "trechos") modoHospitalDefinir(MODO_TRECHOS);
+        else return erro("modo desconhecido");
+        out << "OK\n";
+    } else if (op == "ESCALA") {
+        vector<HospitalMaisProximo> res = atribuirHospitais();
+        out << "OK\t" << res.size() << '\n';
+        for (IdProf id = 0; id < res.size(); id++)
+            out << id << '\t' << res[id].hospital << '\t' << sqrt((double)res[id].dist2) << '\n';
+    } else if (op == "EQUIPES") {
+        if (args != 1 || !lerInt(c[1], a) || a < 0) return erro("uso: EQUIPES raio");
+        vector<EquipeHospital> res = profissionaisPorHospital(a);
+        out << "OK\t" << res.size() << '\n';
+        for (const EquipeHospital &e : res) {
+            out << e.hospital << '\t' << e.profissionais.size() << '\t';
+            for (size_t i = 0; i < e.profissionais.size(); i++)
+                out << (i ? "," : "") << e.profissionais[i].second;
+            out << '\n';
+        }
+    } else if (op == "REGIOES") {
+        vector<vector<int>> regioes = regioesSemHospital();
+        out << "OK\t" << regioes.size() << '\n';
+        for (const vector<int> &r : regioes) {
+            out << r.size() << '\t';
+            for (size_t i = 0; i < r.size(); i++) out << (i ? "," : "") << r[i];
+            out << '\n';
+        }
+    } else if (op == "STATS") {
+        out << "OK\t" << metricasJSON(); // já termina em '\n'
+    } else if (op == "SAIR") {
+        out << "OK\n";
+        return false;
+    } else {
+        return erro("comando desconhecido");
+    }
+    if (ehCadastro && !servidorAdiarCadastros()) pendentesConfirmar(pendentes, out.buf);
+    return true;
+}
+
+/* ===========================
+        LAÇO DE EVENTOS
+=========================== */
+// Executa as linhas completas já recebidas, enquanto a resposta pendente
+// couber no limite, e confirma os cadastros que ficaram pendentes no fim
+inline void servidorProcessar(ConexaoServidor &con) {
+    static vector<string_view> campos;
+    static CadastrosPendentes pendentes;
+    SaidaBuffer out(con.resposta);
+    uint64_t qtd = 0;
+    while (!con.fechar && con.resposta.size() - con.enviado < LIMITE_RESPOSTA) {
+        size_t fim = con.recebido.find('\n', con.lido);
+        if (fim == string::npos) {
+            if (con.recebido.size() - con.lido > LIMITE_LINHA) {
+                out << "ERR\tlinha longa demais\n";
+                con.fechar = true;
+                break;
+            }
+            if (!con.fimEntrada || con.lido == con.recebido.size()) break;
+            fim = con.recebido.size(); // última linha, sem '\n'
+        }
+        dividirCampos(string_view(con.recebido).substr(con.lido, fim - con.lido), campos);
+        con.lido = min(fim + 1, con.recebido.size());
+        if (campos.empty()) continue;
+        qtd++;
+        if (!servidorExecutar(campos, out, pendentes)) con.fechar = true;
+    }
+    pendentesConfirmar(pendentes, con.resposta);
+    if (con.lido == con.recebido.size() || con.lido > TAM_RECEBER) {
+        con.recebido.erase(0, con.lido);
+        con.lido = 0;
+    }
+    if (qtd) metricaRegistrar(MET_LOTE_REQUISICOES, qtd);
+}
+
+inline void conexaoLer(ConexaoServidor &con) {
+    char tmp[TAM_RECEBER];
+    // Limita a leitura por rodada para alternar entre as conexões
+    for (size_t total = 0; total < LIMITE_LINHA;) {
+        ssize_t n = read(con.entrada, tmp, sizeof tmp);
+        if (n > 0) {
+            con.recebido.append(tmp, n);
+            total += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0) con.fimEntrada = true;
+        else if (errno != EAGAIN && errno != EWOULDBLOCK) con.fimEntrada = con.fechar = true;
+        return;
+    }
+}
+
+inline void conexaoEscrever(ConexaoServidor &con) {
+    while (con.enviado < con.resposta.size()) {
+        ssize_t n = write(con.saida, con.resposta.data() + con.enviado,
+                          con.resposta.size() - con.enviado);
+        if (n > 0) {
+            con.enviado += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        // O cliente foi embora: descarta o resto
+        con.resposta.clear();
+        con.enviado = 0;
+        con.fimEntrada = con.fechar = true;
+        return;
+    }
+    if (con.enviado == con.resposta.size()) {
+        con.resposta.clear();
+        con.enviado = 0;
+    } else if (con.enviado > LIMITE_RESPOSTA) {
+        con.resposta.erase(0, con.enviado);
+        con.enviado = 0;
+    }
+}
+
+inline bool conexaoTerminada(const ConexaoServidor &con) {
+    if (!con.resposta.empty()) return false;
+    return con.fechar || (con.fimEntrada && con.lido == con.recebido.size());
+}
+
+inline void servidorSinal(int) { servidorParar = 1; }
+
+inline void servidorTratarSinais() {
+    signal(SIGPIPE, SIG_IGN); // escrita em conexão fechada vira EPIPE
+    struct sigaction sa = {};
+    sa.sa_handler = servidorSinal; // sem SA_RESTART: o poll volta com EINTR
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+}
+
+inline void naoBloqueante(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// Atende as conexões até SIGINT/SIGTERM ou até não restar nenhuma (sem
+// socket de escuta, isto é, no modo stdin)
+inline void servidorLaco(int escuta, vector<ConexaoServidor> &cons) {
+    vector<pollfd> fds;
+    while (!servidorParar && (escuta >= 0 || !cons.empty())) {
+        fds.clear();
+        if (escuta >= 0) fds.push_back({escuta, POLLIN, 0});
+        for (ConexaoServidor &con : cons) {
+            con.pollEntrada = con.pollSaida = -1;
+            if (!con.fimEntrada && !con.fechar && con.resposta.size() - con.enviado < LIMITE_RESPOSTA) {
+                con.pollEntrada = fds.size();
+                fds.push_back({con.entrada, POLLIN, 0});
+            }
+            if (con.enviado < con.resposta.size()) {
+                con.pollSaida = fds.size();
+                fds.push_back({con.saida, POLLOUT, 0});
+            }
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            cerr << "Servidor: poll falhou (" << strerror(errno) << ")\n";
+            break;
+        }
+
+        for (ConexaoServidor &con : cons) {
+            if (con.pollEntrada >= 0 && fds[con.pollEntrada].revents) conexaoLer(con);
+            servidorProcessar(con);
+            conexaoEscrever(con);
+        }
+        for (size_t i = 0; i < cons.size();) {
+            if (!conexaoTerminada(cons[i])) {
+                i++;
+                continue;
+            }
+            if (cons[i].entrada == cons[i].saida) close(cons[i].entrada);
+            cons[i] = move(cons.back());
+            cons.pop_back();
+        }
+
+        if (escuta >= 0 && (fds[0].revents & POLLIN)) {
+            int fd;
+            while ((fd = accept4(escuta, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+                cons.emplace_back(fd, fd);
+        }
+    }
+}
+
+// Protocolo sobre stdin/stdout; termina no fim da entrada, depois de enviar
+// todas as respostas
+inline bool servidorStdin() {
+    servidorTratarSinais();
+    int flagsEntrada = fcntl(0, F_GETFL), flagsSaida = fcntl(1, F_GETFL);
+    naoBloqueante(0);
+    naoBloqueante(1);
+    wal.adiarConfirmacao = true;
+
+    vector<ConexaoServidor> cons;
+    cons.emplace_back(0, 1);
+    servidorLaco(-1, cons);
+
+    wal.adiarConfirmacao = false;
+    fcntl(0, F_SETFL, flagsEntrada);
+    fcntl(1, F_SETFL, flagsSaida);
+    return true;
+}
+
+// Protocolo sobre um socket Unix em 'caminho', com várias conexões
+// simultâneas; termina com SIGINT/SIGTERM
+inline bool servidorSocket(const char *caminho) {
+    sockaddr_un end = {};
+    end.sun_family = AF_UNIX;
+    if (strlen(caminho) >= sizeof end.sun_path) {
+        cerr << "Caminho de socket longo demais: " << caminho << "\n";
+        return false;
+    }
+    strcpy(end.sun_path, caminho);
+
+    // Um socket que sobrou de uma execução anterior é removido; um em uso, não
+    struct stat st;
+    if (lstat(caminho, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        int teste = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool emUso = teste >= 0 && connect(teste, (sockaddr*)&end, sizeof end) == 0;
+        if (teste >= 0) close(teste);
+        if (emUso) {
+            cerr << "Ja existe um servidor em " << caminho << "\n";
+            return false;
+        }
+        unlink(caminho);
+    }
+
+    int escuta = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (escuta < 0 || bind(escuta, (sockaddr*)&end, sizeof end) < 0 || listen(escuta, 128) < 0) {
+        cerr << "Nao foi possivel abrir o socket " << caminho << " (" << strerror(errno) << ")\n";
+        if (escuta >= 0) close(escuta);
+        return false;
+    }
+    cout << "Servidor aguardando em " << caminho << endl;
+
+    servidorTratarSinais();
+    wal.adiarConfirmacao = true;
+    vector<ConexaoServidor> cons;
+    servidorLaco(escuta, cons);
+    wal.adiarConfirmacao = false;
+
+    for (ConexaoServidor &con : cons) close(con.entrada);
+    close(escuta);
+    unlink(caminho);
+    return true;
+}
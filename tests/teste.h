@@ -0,0 +1,23 @@
+// Verificações mínimas dos testes (sem framework): cada falha é impressa com
+// arquivo e linha, e o programa termina com código 1 se houver alguma.
+#pragma once
+#include <cstdio>
+
+inline int falhasTeste = 0;
+
+#define VERIFICAR(cond, ...)                                                   \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            if (++falhasTeste <= 20) {                                         \
+                fprintf(stderr, "%s:%d: falhou %s: ", __FILE__, __LINE__, #cond); \
+                fprintf(stderr, __VA_ARGS__);                                  \
+                fputc('\n', stderr);                                           \
+            }                                                                  \
+        }                                                                      \
+    } while (0)
+
+inline int resultadoTeste(const char *nome, long long verificados) {
+    if (falhasTeste) fprintf(stderr, "%s: %d falha(s)\n", nome, falhasTeste);
+    else printf("%s: ok (%lld casos)\n", nome, verificados);
+    return falhasTeste ? 1 : 0;
+}
@@ -0,0 +1,140 @@
+// Busca por nome: buscarPrefixo e buscarAproximado (Levenshtein em faixa com
+// poda por prefixo sobre a árvore de nomes normalizados) comparadas com uma
+// varredura de todos os nomes. Os cadastros continuam depois da primeira
+// busca, então o índice normalizado também é testado na manutenção. A versão
+// publicada a cada rodada (array ordenado de chaves) deve responder igual à
+// árvore, assim como as páginas por nome e por especialidade.
+#include "registro_saude.h"
+#include "teste.h"
+#include <random>
+
+static int levenshtein(const string &a, const string &b) {
+    vector<int> ant(b.size() + 1), lin(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); j++) ant[j] = (int)j;
+    for (size_t i = 1; i <= a.size(); i++) {
+        lin[0] = (int)i;
+        for (size_t j = 1; j <= b.size(); j++)
+            lin[j] = min({ant[j] + 1, lin[j - 1] + 1, ant[j - 1] + (a[i - 1] != b[j - 1])});
+        swap(ant, lin);
+    }
+    return ant[b.size()];
+}
+
+int main() {
+    mt19937 rng(23);
+    long long verificados = 0;
+    vector<string> normalizados; // por IdProf
+
+    // Poucas letras e nomes curtos geram muitos vizinhos a 1-3 edições e
+    // muitas chaves com o mesmo prefixo (várias folhas da árvore)
+    const char *PARTES[] = {"Ana", "Ána", "ANA", "ab", "ba", "abc", "Conceição", "Conceicao", "João",
+                            "Joao", "José", "Lúcia", "lucia", "Inês", "b", "c", "ca", "Zé"};
+    const int QTD_PARTES = sizeof(PARTES) / sizeof(PARTES[0]);
+    auto nomeAleatorio = [&]() {
+        string s;
+        int partes = 1 + rng() % 3;
+        for (int i = 0; i < partes; i++) {
+            if (i) s += rng() % 5 ? " " : "  ";
+            s += PARTES[rng() % QTD_PARTES];
+        }
+        if (rng() % 3 == 0) s += "abc"[rng() % 3];
+        return s;
+    };
+    // Consulta: um nome cadastrado com algumas edições, um pedaço dele ou
+    // um nome sorteado
+    auto consultaAleatoria = [&]() {
+        string s = normalizados.empty() || rng() % 4 == 0 ? nomeAleatorio() : normalizados[rng() % normalizados.size()];
+        int edicoes = rng() % 4;
+        for (int e = 0; e < edicoes && !s.empty(); e++) {
+            size_t p = rng() % s.size();
+            switch (rng() % 3) {
+                case 0: s.erase(p, 1); break;
+                case 1: s.insert(s.begin() + p, "abcz"[rng() % 4]); break;
+                default: s[p] = "abcz"[rng() % 4];
+            }
+        }
+        if (rng() % 3 == 0) s.resize(rng() % (s.size() + 1));
+        return s;
+    };
+
+    int crm = 1;
+    for (int rodada = 0; rodada < 8; rodada++) {
+        int novos = rodada == 0 ? 400 : 1 + rng() % 300;
+        string chave;
+        for (int i = 0; i < novos; i++) {
+            string nome = nomeAleatorio();
+            IdProf id = profissionalInserir(nome, (IdEsp)(rng() % QTD_ESPECIALIDADES), crm++, {0, 0});
+            normalizarNome(nome, chave);
+            VERIFICAR(id == normalizados.size(), "profissionalInserir devolveu %u", id);
+            normalizados.push_back(chave);
+        }
+        RegistroSaude reg;
+        registroIniciar(reg);
+
+        for (int q = 0; q < 60; q++) {
+            string consulta = consultaAleatoria(), nq;
+            normalizarNome(consulta, nq);
+
+            // Prefixo: mesmas chaves, em ordem de nome, até o limite
+            vector<string> esperadas;
+            for (const string &s : normalizados)
+                if (s.compare(0, nq.size(), nq) == 0) esperadas.push_back(s);
+            sort(esperadas.begin(), esperadas.end());
+            size_t limite = rng() % 2 ? esperadas.size() + 1 : rng() % 10;
+            vector<IdProf> r = buscarPrefixo(consulta, limite);
+            verificados += 2;
+            VERIFICAR(registroBuscarPrefixo(reg, consulta, limite) == r,
+                      "prefixo \"%s\": versão publicada difere da árvore", consulta.c_str());
+            VERIFICAR(r.size() == min(limite, esperadas.size()), "prefixo \"%s\": %zu resultados, esperado %zu",
+                      consulta.c_str(), r.size(), min(limite, esperadas.size()));
+            for (size_t i = 0; i < r.size() && i < esperadas.size(); i++)
+                VERIFICAR(normalizados[r[i]] == esperadas[i], "prefixo \"%s\"[%zu]: \"%s\", esperado \"%s\"",
+                          consulta.c_str(), i, normalizados[r[i]].c_str(), esperadas[i].c_str());
+
+            // Aproximada: (distância, chave) de todos a no máximo maxDist
+            // edições, em ordem; maxDist fora de 0..MAX_DIST_EDICAO é limitado
+            int pedido = (int)(rng() % (MAX_DIST_EDICAO + 3)) - 1;
+            int maxDist = max(0, min(pedido, MAX_DIST_EDICAO));
+            vector<pair<int, string>> proximos;
+            for (const string &s : normalizados) {
+                int d = levenshtein(s, nq);
+                if (d <= maxDist) proximos.push_back({d, s});
+            }
+            sort(proximos.begin(), proximos.end());
+            limite = rng() % 2 ? proximos.size() + 1 : rng() % 10;
+            vector<NomeAproximado> a = buscarAproximado(consulta, pedido, limite);
+            vector<NomeAproximado> av = registroBuscarAproximado(reg, consulta, pedido, limite);
+            verificados += 2;
+            VERIFICAR(av.size() == a.size() && equal(a.begin(), a.end(), av.begin(),
+                                                     [](const NomeAproximado &x, const NomeAproximado &y) {
+                                                         return x.id == y.id && x.distancia == y.distancia;
+                                                     }),
+                      "aproximado \"%s\" (%d): versão publicada difere da árvore", consulta.c_str(), pedido);
+            VERIFICAR(a.size() == min(limite, proximos.size()),
+                      "aproximado \"%s\" (%d): %zu resultados, esperado %zu", consulta.c_str(), pedido,
+                      a.size(), min(limite, proximos.size()));
+            for (size_t i = 0; i < a.size() && i < proximos.size(); i++) {
+                const string &s = normalizados[a[i].id];
+                VERIFICAR(a[i].distancia == levenshtein(s, nq) && a[i].distancia == proximos[i].first &&
+                              s == proximos[i].second,
+                          "aproximado \"%s\" (%d)[%zu]: \"%s\" a %d, esperado \"%s\" a %d", consulta.c_str(),
+                          pedido, i, s.c_str(), a[i].distancia, proximos[i].second.c_str(),
+                          proximos[i].first);
+            }
+
+            // Páginas a partir de um nome ou ID sorteado
+            size_t n = 1 + rng() % 30;
+            string apos = rng() % 4 ? string(prof(rng() % cadastro.registros.size()).nome) : consulta;
+            IdEsp esp = (IdEsp)(rng() % QTD_ESPECIALIDADES);
+            IdProf cursor = rng() % 4 ? (IdProf)(rng() % cadastro.registros.size()) : SEM_ID;
+            verificados += 2;
+            VERIFICAR(registroPaginaPorNome(reg, apos, n) == paginaPorNome(arvoreNome, apos, n),
+                      "página por nome após \"%s\": versão publicada difere", apos.c_str());
+            VERIFICAR(registroPaginaEspecialidade(reg, esp, cursor, n) ==
+                          paginaEspecialidade(indiceEsp, esp, cursor, n),
+                      "página da especialidade %d após %u: versão publicada difere", esp, cursor);
+        }
+        registroEncerrar(reg);
+    }
+    return resultadoTeste("teste_busca", verificados);
+}
@@ -0,0 +1,72 @@
+// Junção profissionais x hospitais: atribuirHospitais e
+// profissionaisPorHospital comparados com força bruta, com pontos espalhados
+// e nos extremos do plano (blocos cujo centro é cortado a INT_MIN/INT_MAX e
+// hospitais a mais de 3e9 unidades, com distância² saturada).
+#include "nucleo.h"
+#include "teste.h"
+#include <random>
+
+static long long dist2Exata(Coord a, Coord b) {
+    __int128 dx = (__int128)a.x - b.x, dy = (__int128)a.y - b.y, d = dx * dx + dy * dy;
+    return d > LLONG_MAX ? LLONG_MAX : (long long)d;
+}
+
+int main() {
+    mt19937_64 rng(24);
+    long long verificados = 0;
+    const int32_t EXTREMOS[] = {INT_MIN, INT_MIN + 1, INT_MAX, INT_MAX - 1, INT_MAX - 700, 0, -1};
+    vector<Coord> profs;
+    vector<int> hosps;
+
+    for (int rodada = 0; rodada < 6; rodada++) {
+        // Poucos hospitais na primeira rodada: os blocos ficam enormes e o
+        // hospital mais próximo, longe
+        int novosHosp = rodada == 0 ? 2 : 4 + rng() % 20;
+        for (int i = 0; i < novosHosp; i++) {
+            Coord c = {(int32_t)rng(), (int32_t)rng()};
+            if (rng() % 3 == 0) c = {EXTREMOS[rng() % 7], EXTREMOS[rng() % 7]};
+            int v = cidadeInserir("h" + to_string(qtdCidades + 1), true, c);
+            if (temPosicao(c)) hosps.push_back(v); // (INT_MIN, INT_MIN) = sem coordenada
+            cidadeInserir("c" + to_string(qtdCidades + 1), false, c); // sem hospital: ignorada
+        }
+        for (int i = 0; i < 400; i++) {
+            Coord p = {(int32_t)rng(), (int32_t)rng()};
+            if (rng() % 4 == 0) p = {EXTREMOS[rng() % 7], (int32_t)rng()};
+            if (rng() % 4 == 0) p = {EXTREMOS[rng() % 7], EXTREMOS[rng() % 7]};
+            profissionalInserir("p" + to_string(profs.size()), 0, (int)profs.size(), p);
+            profs.push_back(p);
+        }
+
+        vector<HospitalMaisProximo> a = atribuirHospitais();
+        for (size_t id = 0; id < profs.size(); id++) {
+            int melhor = -1;
+            long long d = 0;
+            for (int h : hosps) {
+                long long dh = dist2Exata(profs[id], cidades.pos[h]);
+                if (melhor == -1 || dh < d || (dh == d && h < melhor)) melhor = h, d = dh;
+            }
+            verificados++;
+            VERIFICAR(a[id].hospital == melhor && a[id].dist2 == d,
+                      "rodada %d: profissional %zu em (%d,%d): hospital %d (d² %lld), esperado %d (d² %lld)",
+                      rodada, id, profs[id].x, profs[id].y, a[id].hospital, a[id].dist2, melhor, d);
+        }
+
+        int raio = rodada % 2 ? INT_MAX : (int)(rng() % 2000000000);
+        vector<EquipeHospital> e = profissionaisPorHospital(raio);
+        VERIFICAR(e.size() == hosps.size(), "rodada %d: %zu equipes, esperado %zu", rodada, e.size(), hosps.size());
+        for (size_t i = 0; i < e.size() && i < hosps.size(); i++) {
+            Coord c = cidades.pos[hosps[i]];
+            vector<Vizinho> esperado;
+            for (size_t id = 0; id < profs.size(); id++) {
+                long long d = dist2Exata(c, profs[id]);
+                if (d <= (long long)raio * raio) esperado.push_back({d, (IdProf)id});
+            }
+            sort(esperado.begin(), esperado.end());
+            verificados++;
+            VERIFICAR(e[i].hospital == hosps[i] && e[i].profissionais == esperado,
+                      "rodada %d: hospital %d raio %d: %zu profissionais, esperado %zu", rodada, hosps[i], raio,
+                      e[i].profissionais.size(), esperado.size());
+        }
+    }
+    return resultadoTeste("teste_juncao", verificados);
+}
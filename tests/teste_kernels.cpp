@@ -0,0 +1,163 @@
+// Kernels de raio: cada versão (escalar, SSE4.2 e AVX2, as duas últimas só
+// se a CPU as tiver) chamada diretamente e comparada com o cálculo exato em
+// inteiros, com coordenadas nos extremos (INT_MIN/INT_MAX), raio 0, negativo
+// e INT_MAX, ponteiros desalinhados e tamanhos que não são múltiplos da
+// largura do vetor. No fim, gradeRaio, gradeRaioLote e gradeKProximos
+// contra força bruta, e o k mais próximos por especialidade no índice, na
+// visão montada em memória e no snapshot gravado e reaberto.
+#include "nucleo.h"
+#include "teste.h"
+#include <random>
+
+// Referência exata só com inteiros de 64 bits: |dx|, |dy| < 2^32, então cada
+// quadrado cabe em uint64_t e só a soma pode passar de 2^64 (vai-um)
+static bool dentroDoRaio(int32_t x, int32_t y, Coord c, int raio) {
+    uint64_t dx = (uint64_t)((int64_t)x - c.x), dy = (uint64_t)((int64_t)y - c.y);
+    if ((int64_t)dx < 0) dx = -dx;
+    if ((int64_t)dy < 0) dy = -dy;
+    uint64_t r = (uint64_t)max(raio, 0), soma = dx * dx + dy * dy;
+    return soma >= dx * dx && soma <= r * r;
+}
+
+struct Variante {
+    KernelRaio raio;
+    const char *nome;
+};
+
+int main() {
+    mt19937_64 rng(25);
+    long long verificados = 0;
+
+    vector<Variante> variantes{{raioEscalar, "escalar"}};
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) variantes.push_back({raioSSE42, "sse4.2"});
+    if (__builtin_cpu_supports("avx2")) variantes.push_back({raioAVX2, "avx2"});
+#endif
+    for (const Variante &v : variantes) printf("kernel %s\n", v.nome);
+
+    const int32_t EXTREMOS[] = {INT_MIN, INT_MIN + 1, INT_MAX, INT_MAX - 1, 0, -1, 1};
+    for (int t = 0; t < 30000; t++) {
+        size_t n = rng() % 41, deslocamento = rng() % 4;
+        int modo = t % 3;
+        auto valor = [&]() -> int32_t {
+            if (modo == 0) return (int32_t)(rng() % 2001) - 1000;
+            if (modo == 1) return rng() % 2 ? EXTREMOS[rng() % 7] : (int32_t)rng();
+            return (int32_t)rng();
+        };
+        vector<int32_t> x(n + deslocamento), y(n + deslocamento);
+        for (size_t i = deslocamento; i < n + deslocamento; i++) x[i] = valor(), y[i] = valor();
+        Coord c = {valor(), valor()};
+        if (n && rng() % 10 == 0) c = {x[deslocamento], y[deslocamento]};
+        int raio;
+        switch (rng() % 6) {
+            case 0: raio = 0; break;
+            case 1: raio = INT_MAX; break;
+            case 2: raio = -(int)(rng() % 5) - (rng() % 2 ? 0 : INT_MAX - 4); break;
+            default: raio = modo == 0 ? (int)(rng() % 600) : (int)(rng() % INT_MAX);
+        }
+        uint32_t base = (uint32_t)(rng() % 1000000);
+
+        // Raio negativo vale como 0
+        vector<uint32_t> esperado;
+        for (size_t i = 0; i < n; i++)
+            if (dentroDoRaio(x[deslocamento + i], y[deslocamento + i], c, raio))
+                esperado.push_back(base + (uint32_t)i);
+
+        // As versões vetoriais podem escrever até 8 posições além do último
+        // aceito; daí em diante a saída tem de ficar intacta
+        const uint32_t SENTINELA = 0xDEADBEEF;
+        for (const Variante &v : variantes) {
+            vector<uint32_t> saida(n + 16, SENTINELA);
+            size_t k = v.raio(x.data() + deslocamento, y.data() + deslocamento, n, c, raio, base, saida.data());
+            verificados++;
+            VERIFICAR(k == esperado.size() && equal(esperado.begin(), esperado.end(), saida.begin()),
+                      "%s: n=%zu centro=(%d,%d) raio=%d: %zu aceitos, esperado %zu", v.nome, n, c.x, c.y, raio,
+                      k, esperado.size());
+            VERIFICAR(all_of(saida.begin() + n + 8, saida.end(), [&](uint32_t s) { return s == SENTINELA; }),
+                      "%s: n=%zu escreveu além da folga de 8 posições", v.nome, n);
+        }
+    }
+
+    // Grade: pontos espalhados, consultas de raio pequeno (célula a célula)
+    // a enorme (varredura completa pelo kernel)
+    vector<Coord> pos;
+    for (int i = 0; i < 20000; i++) {
+        Coord p = {(int)(rng() % 100000) - 50000, (int)(rng() % 100000)};
+        if (i % 500 == 0) p = {EXTREMOS[rng() % 7], EXTREMOS[rng() % 7]};
+        pos.push_back(p);
+        profissionalInserir("p" + to_string(i), (IdEsp)(i % QTD_ESPECIALIDADES), i, p);
+    }
+    vector<Coord> centros;
+    for (int q = 0; q < 100; q++) centros.push_back({(int)(rng() % 120000) - 60000, (int)(rng() % 120000) - 10000});
+    centros.push_back({INT_MIN, INT_MAX});
+    for (int raio : {0, 100, 700, 3000, 200000, INT_MAX}) {
+        vector<vector<Vizinho>> lote = gradeRaioLote(grade, centros, raio);
+        for (size_t q = 0; q < centros.size(); q++) {
+            Coord c = centros[q];
+            vector<Vizinho> esperado;
+            for (size_t i = 0; i < pos.size(); i++)
+                if (dentroDoRaio(pos[i].x, pos[i].y, c, raio))
+                    esperado.push_back({dist2(c, pos[i].x, pos[i].y), (IdProf)i});
+            sort(esperado.begin(), esperado.end());
+            vector<Vizinho> r = gradeRaio(grade, c, raio);
+            verificados += 2;
+            VERIFICAR(r == esperado, "gradeRaio centro=(%d,%d) raio=%d: %zu pontos, esperado %zu", c.x, c.y, raio,
+                      r.size(), esperado.size());
+            VERIFICAR(lote[q] == r, "gradeRaioLote centro=(%d,%d) raio=%d difere de gradeRaio", c.x, c.y, raio);
+        }
+    }
+
+    // k mais próximos a partir dos cantos: as distâncias² passam de 2^63 e
+    // têm de saturar em LLONG_MAX, não dar a volta para negativas
+    auto dist2Exata = [](Coord c, Coord p) {
+        __int128 dx = (__int128)c.x - p.x, dy = (__int128)c.y - p.y, d = dx * dx + dy * dy;
+        return d > LLONG_MAX ? LLONG_MAX : (long long)d;
+    };
+    centros.push_back({INT_MAX, INT_MIN});
+    centros.push_back({INT_MAX, INT_MAX});
+    for (int k : {1, 7, 60}) {
+        for (Coord c : centros) {
+            vector<long long> esperado;
+            for (Coord p : pos) esperado.push_back(dist2Exata(c, p));
+            sort(esperado.begin(), esperado.end());
+            esperado.resize(min<size_t>(k, esperado.size()));
+            vector<Vizinho> r = gradeKProximos(grade, c, k);
+            bool ok = r.size() == esperado.size();
+            for (size_t i = 0; ok && i < r.size(); i++)
+                ok = r[i].first == esperado[i] && r[i].first == dist2Exata(c, pos[r[i].second]);
+            verificados++;
+            VERIFICAR(ok, "gradeKProximos centro=(%d,%d) k=%d: distâncias diferentes da força bruta", c.x, c.y, k);
+        }
+    }
+
+    // Por especialidade: cada caminho usa a grade própria (TAM_CELULA_ESP)
+    ImagemProfissionais imagem;
+    imagemProfissionaisMontar(imagem);
+    Snapshot visao;
+    visaoProfissionais(visao, imagem);
+    const char *arquivo = "teste_kernels.snap";
+    VERIFICAR(snapshotSalvar(arquivo) && snapshotAbrir(arquivo), "snapshot %s nao gravado/reaberto", arquivo);
+    for (int esp = 0; esp < QTD_ESPECIALIDADES; esp++) {
+        for (int k : {1, 9}) {
+            for (Coord c : centros) {
+                vector<long long> esperado;
+                for (size_t i = esp; i < pos.size(); i += QTD_ESPECIALIDADES) esperado.push_back(dist2Exata(c, pos[i]));
+                sort(esperado.begin(), esperado.end());
+                esperado.resize(min<size_t>(k, esperado.size()));
+                vector<Vizinho> caminhos[] = {espKProximos(indiceEsp, (IdEsp)esp, c, k), snapKProximosEsp(visao, (IdEsp)esp, c, k),
+                                              snapKProximosEsp(snap, (IdEsp)esp, c, k)};
+                for (const vector<Vizinho> &r : caminhos) {
+                    bool ok = r.size() == esperado.size();
+                    for (size_t i = 0; ok && i < r.size(); i++)
+                        ok = r[i].first == esperado[i] && (int)r[i].second % QTD_ESPECIALIDADES == esp;
+                    verificados++;
+                    VERIFICAR(ok, "k mais próximos esp=%d centro=(%d,%d) k=%d: %zu vizinhos diferentes da força bruta",
+                              esp, c.x, c.y, k, r.size());
+                }
+            }
+        }
+    }
+    remove(arquivo);
+    return resultadoTeste("teste_kernels", verificados);
+}
@@ -0,0 +1,106 @@
+// Modo trechos: rotaLargura (BFS que alterna top-down e bottom-up) comparada
+// com uma BFS comum por fila com as mesmas regras de empate: vence o hospital
+// de menor ID no nível mais raso, e a rota volta pelo predecessor de menor ID
+// no nível anterior. Hospital, custo e caminho têm de ser idênticos.
+#include "nucleo.h"
+#include "teste.h"
+#include <random>
+
+struct MapaReferencia {
+    vector<vector<int>> saida{1}, entrada{1};
+    vector<uint8_t> hosp{0};
+};
+
+static RotaHospital larguraReferencia(const MapaReferencia &m, int inicio) {
+    RotaHospital r;
+    vector<int> nivel(m.saida.size(), -1);
+    vector<int> fila{inicio};
+    nivel[inicio] = 0;
+    for (size_t i = 0; i < fila.size(); i++)
+        for (int u : m.saida[fila[i]])
+            if (nivel[u] == -1) {
+                nivel[u] = nivel[fila[i]] + 1;
+                fila.push_back(u);
+            }
+    for (int v : fila) {
+        if (!m.hosp[v]) continue;
+        if (r.hospital == -1 || nivel[v] < nivel[r.hospital] ||
+            (nivel[v] == nivel[r.hospital] && v < r.hospital))
+            r.hospital = v;
+    }
+    if (r.hospital == -1) return r;
+    r.custo = nivel[r.hospital];
+    for (int v = r.hospital;; ) {
+        r.caminho.push_back(v);
+        if (v == inicio) break;
+        int ant = INT_MAX;
+        for (int u : m.entrada[v])
+            if (nivel[u] == nivel[v] - 1) ant = min(ant, u);
+        v = ant;
+    }
+    reverse(r.caminho.begin(), r.caminho.end());
+    return r;
+}
+
+int main() {
+    mt19937 rng(20);
+    MapaReferencia m;
+    long long verificados = 0;
+
+    // Cada fase acrescenta cidades (nem sempre múltiplo de 64) e vias; o mapa
+    // vai de esparso a denso, para que a busca passe pelas duas direções, e
+    // parte das vias fica no buffer e parte no CSR
+    struct Fase { int cidades, grau, hospPorMil; };
+    const Fase FASES[] = {{1, 0, 1000}, {70, 2, 20}, {300, 3, 5}, {630, 12, 3},
+                          {1, 1, 0}, {500, 30, 2}, {1500, 4, 1}};
+    auto novaCidade = [&](bool h) {
+        cidadeInserir("c" + to_string(m.saida.size()), h);
+        m.saida.emplace_back();
+        m.entrada.emplace_back();
+        m.hosp.push_back(h);
+    };
+    auto novaVia = [&](int o, int d) {
+        if (grafoBuscarAresta(grafo, o, d)) return;
+        viaInserir(o, d, 1 + rng() % 50);
+        m.saida[o].push_back(d);
+        m.entrada[d].push_back(o);
+    };
+    auto conferir = [&](int v) {
+        int n = qtdCidades;
+        RotaHospital a = rotaLargura(grafo, grafoReverso, hospital, qtdCidades, v);
+        RotaHospital e = larguraReferencia(m, v);
+        verificados++;
+        VERIFICAR(a.hospital == e.hospital, "n=%d origem %d: hospital %d, esperado %d", n, v, a.hospital,
+                  e.hospital);
+        VERIFICAR(a.custo == e.custo, "n=%d origem %d: %lld trechos, esperado %lld", n, v,
+                  (long long)a.custo, (long long)e.custo);
+        VERIFICAR(a.caminho == e.caminho, "n=%d origem %d: caminho diferente da BFS de referência", n, v);
+    };
+
+    for (const Fase &f : FASES) {
+        for (int i = 0; i < f.cidades; i++) novaCidade((int)(rng() % 1000) < f.hospPorMil);
+        int n = qtdCidades;
+        for (int i = 0; i < f.cidades * f.grau; i++) novaVia(1 + rng() % n, 1 + rng() % n);
+        for (int q = 0; q < 400; q++) conferir(q < n ? 1 + q : 1 + rng() % n);
+    }
+
+    // Leque: a origem s leva a 80 cidades sem hospital, todas ligadas a um
+    // bloco de 128 cidades com alguns hospitais. A fronteira do nível
+    // 1 já basta para virar bottom-up, e o nível 2 acha vários hospitais na
+    // mesma palavra do bitset (e cidades do bloco com vários predecessores).
+    for (int leque = 0; leque < 6; leque++) {
+        int s = qtdCidades + 1;
+        novaCidade(false);
+        for (int i = 0; i < 80; i++) novaCidade(false);
+        for (int i = 0; i < 128; i++) novaCidade(rng() % 100 < 5);
+        int blocoA = s + 1, blocoB = s + 81;
+        for (int i = 0; i < 80; i++) {
+            novaVia(s, blocoA + i);
+            for (int j = 0; j < 128; j++) novaVia(blocoA + i, blocoB + j);
+        }
+        for (int i = 0; i < 128; i++) novaVia(blocoB + i, 1 + rng() % (s - 1));
+        conferir(s);
+        for (int i = 0; i < 20; i++) conferir(blocoA + rng() % 80);
+    }
+    return resultadoTeste("teste_largura", verificados);
+}
@@ -0,0 +1,106 @@
+// Alcance de hospitais: a marcação incremental sobre as componentes fortes
+// (alcancaHospital) e regioesSemHospital, do estado em memória e da versão
+// publicada, comparadas com força bruta (busca a partir de cada cidade)
+// enquanto cidades, hospitais e vias são cadastrados.
+#include "registro_saude.h"
+#include "teste.h"
+#include <random>
+
+struct MapaReferencia {
+    vector<vector<int>> saida{1};
+    vector<uint8_t> hosp{0};
+};
+
+static vector<uint8_t> alcancaveis(const MapaReferencia &m, int inicio) {
+    vector<uint8_t> visto(m.saida.size(), 0);
+    vector<int> pilha{inicio};
+    visto[inicio] = 1;
+    while (!pilha.empty()) {
+        int v = pilha.back();
+        pilha.pop_back();
+        for (int u : m.saida[v])
+            if (!visto[u]) {
+                visto[u] = 1;
+                pilha.push_back(u);
+            }
+    }
+    return visto;
+}
+
+int main() {
+    mt19937 rng(21);
+    MapaReferencia m;
+    long long verificados = 0;
+    RegistroSaude reg;
+    registroIniciar(reg);
+
+    for (int rodada = 0; rodada < 14; rodada++) {
+        int novas = 5 + rng() % 30;
+        for (int i = 0; i < novas; i++) {
+            bool h = rng() % 100 < 3;
+            registroCidade(reg, "c" + to_string(m.saida.size()), h);
+            m.saida.emplace_back();
+            m.hosp.push_back(h);
+        }
+        int n = qtdCidades;
+        // Vias entre cidades próximas formam muitas componentes pequenas;
+        // algumas longas as juntam aos poucos
+        int qtdVias = novas * 2;
+        for (int i = 0; i < qtdVias; i++) {
+            int o = 1 + rng() % n;
+            int d = rng() % 8 ? max(1, min(n, o + (int)(rng() % 11) - 5)) : 1 + (int)(rng() % n);
+            registroVia(reg, o, d, 1 + rng() % 9);
+            m.saida[o].push_back(d);
+            // Consulta no meio dos cadastros: o índice é mantido a cada via,
+            // sem reconstrução na consulta
+            if (rng() % 4 == 0) {
+                int v = 1 + rng() % n;
+                vector<uint8_t> r = alcancaveis(m, v);
+                bool esperado = false;
+                for (int u = 1; u <= n && !esperado; u++) esperado = r[u] && m.hosp[u];
+                verificados++;
+                VERIFICAR(alcancaHospital(v) == esperado, "rodada %d: alcancaHospital(%d) deveria ser %d",
+                          rodada, v, esperado);
+            }
+        }
+
+        vector<vector<uint8_t>> alc(n + 1);
+        for (int v = 1; v <= n; v++) alc[v] = alcancaveis(m, v);
+        vector<uint8_t> chega(n + 1, 0);
+        for (int v = 1; v <= n; v++)
+            for (int u = 1; u <= n && !chega[v]; u++) chega[v] = alc[v][u] && m.hosp[u];
+        for (int v = 1; v <= n; v++) {
+            verificados++;
+            VERIFICAR(alcancaHospital(v) == (bool)chega[v], "rodada %d: alcancaHospital(%d) deveria ser %d",
+                      rodada, v, chega[v]);
+        }
+
+        // Componentes fortes por força bruta: u e v na mesma se um alcança o
+        // outro; ordem documentada: maior primeiro, empate pela menor cidade
+        vector<vector<int>> esperado;
+        vector<uint8_t> usada(n + 1, 0);
+        for (int v = 1; v <= n; v++) {
+            if (usada[v] || chega[v]) continue;
+            vector<int> comp;
+            for (int u = v; u <= n; u++)
+                if (alc[v][u] && alc[u][v]) {
+                    comp.push_back(u);
+                    usada[u] = 1;
+                }
+            esperado.push_back(comp);
+        }
+        sort(esperado.begin(), esperado.end(), [](const vector<int> &x, const vector<int> &y) {
+            return x.size() != y.size() ? x.size() > y.size() : x[0] < y[0];
+        });
+        // A publicação condensa o índice por conta própria, antes do
+        // relatório em memória
+        registroPublicar(reg);
+        verificados += 2;
+        VERIFICAR(registroRegioesSemHospital(reg) == esperado,
+                  "rodada %d: regiões da versão publicada diferentes da força bruta", rodada);
+        VERIFICAR(regioesSemHospital() == esperado, "rodada %d: regiões sem hospital diferentes da força bruta",
+                  rodada);
+    }
+    registroEncerrar(reg);
+    return resultadoTeste("teste_regioes", verificados);
+}
@@ -0,0 +1,194 @@
+// Rotas até hospital: CH, tabela, trechos e o cache de kHospitais (do estado
+// em memória e das versões publicadas) comparados com um Dijkstra/BFS de
+// referência sobre o mesmo mapa, em grafos aleatórios que crescem por rodadas
+// (cidades e vias novas entre as consultas). Parte dos tempos fica perto de
+// INT_MAX para exercitar as somas em 64 bits.
+#include "registro_saude.h"
+#include "teste.h"
+#include <map>
+#include <random>
+
+// Mapa de referência: menor tempo por par (o, d), como em grafoAdicionarAresta
+struct MapaReferencia {
+    vector<map<int, int>> vias{1};
+    vector<uint8_t> hosp{0};
+};
+
+static vector<Custo> distanciasReferencia(const MapaReferencia &m, int inicio, bool unitario) {
+    vector<Custo> dist(m.vias.size(), DIST_INF);
+    HeapMin heap;
+    dist[inicio] = 0;
+    heap.push({0, inicio});
+    while (!heap.empty()) {
+        auto [d, v] = heap.top();
+        heap.pop();
+        if (d != dist[v]) continue;
+        for (auto [u, w] : m.vias[v]) {
+            Custo nd = d + (unitario ? 1 : w);
+            if (nd < dist[u]) {
+                dist[u] = nd;
+                heap.push({nd, u});
+            }
+        }
+    }
+    return dist;
+}
+
+// Custos dos k hospitais mais próximos, em ordem crescente
+static vector<Custo> kCustosReferencia(const MapaReferencia &m, const vector<Custo> &dist, int k) {
+    vector<Custo> custos;
+    for (size_t v = 1; v < dist.size(); v++)
+        if (m.hosp[v] && dist[v] != DIST_INF) custos.push_back(dist[v]);
+    sort(custos.begin(), custos.end());
+    if ((int)custos.size() > k) custos.resize(k);
+    return custos;
+}
+
+// A rota sai de inicio, segue vias existentes, termina no hospital informado
+// e custa o que diz (cada via vale 1 com 'unitario')
+static bool rotaValida(const MapaReferencia &m, const RotaHospital &r, int inicio, bool unitario) {
+    if (r.caminho.empty() || r.caminho[0] != inicio || r.caminho.back() != r.hospital) return false;
+    if (!m.hosp[r.hospital]) return false;
+    Custo soma = 0;
+    for (size_t i = 1; i < r.caminho.size(); i++) {
+        auto it = m.vias[r.caminho[i - 1]].find(r.caminho[i]);
+        if (it == m.vias[r.caminho[i - 1]].end()) return false;
+        soma += unitario ? 1 : it->second;
+    }
+    return soma == r.custo;
+}
+
+static long long verificados = 0;
+
+static void conferirRota(const MapaReferencia &m, const RotaHospital &r, Custo esperado, int v,
+                         bool unitario, const char *modo) {
+    verificados++;
+    if (esperado == DIST_INF) {
+        VERIFICAR(r.hospital == -1, "%s: cidade %d sem hospital alcançável, achou %d", modo, v, r.hospital);
+        return;
+    }
+    VERIFICAR(r.hospital != -1 && r.custo == esperado, "%s: cidade %d custo %lld, esperado %lld", modo,
+              v, (long long)r.custo, (long long)esperado);
+    VERIFICAR(r.hospital == -1 || rotaValida(m, r, v, unitario), "%s: rota inválida a partir de %d", modo, v);
+}
+
+static void conferirK(const MapaReferencia &m, const vector<RotaHospital> &rotas,
+                      const vector<Custo> &esperado, int v, bool unitario) {
+    verificados++;
+    VERIFICAR(rotas.size() == esperado.size(), "kHospitais(%d, trechos=%d): %zu rotas, esperado %zu", v,
+              unitario, rotas.size(), esperado.size());
+    vector<int> vistos;
+    for (size_t i = 0; i < rotas.size() && i < esperado.size(); i++) {
+        VERIFICAR(rotas[i].custo == esperado[i], "kHospitais(%d, trechos=%d)[%zu]: custo %lld, esperado %lld",
+                  v, unitario, i, (long long)rotas[i].custo, (long long)esperado[i]);
+        VERIFICAR(rotaValida(m, rotas[i], v, unitario), "kHospitais(%d, trechos=%d)[%zu]: rota inválida", v,
+                  unitario, i);
+        vistos.push_back(rotas[i].hospital);
+    }
+    sort(vistos.begin(), vistos.end());
+    VERIFICAR(adjacent_find(vistos.begin(), vistos.end()) == vistos.end(),
+              "kHospitais(%d, trechos=%d): hospital repetido", v, unitario);
+}
+
+int main() {
+    mt19937 rng(2024);
+    MapaReferencia m;
+    auto sortearTempo = [&]() -> int {
+        uint32_t r = rng() % 100;
+        if (r < 85) return 1 + rng() % 100;
+        if (r < 95) return INT_MAX - (int)(rng() % 1000);
+        return 1 + rng() % 1000000000;
+    };
+
+    // Os cadastros passam pelo RegistroSaude, que publica uma versão por
+    // rodada: o cache de hospitais de cada versão herda o da anterior
+    RegistroSaude reg;
+    registroIniciar(reg);
+
+    const int RODADAS = 12;
+    size_t nucleoMaximo = 0;
+    for (int rodada = 0; rodada < RODADAS; rodada++) {
+        int novas = 20 + rng() % 20;
+        for (int i = 0; i < novas; i++) {
+            bool h = rng() % 100 < 12;
+            int id = registroCidade(reg, "c" + to_string(m.vias.size()), h);
+            VERIFICAR(id == (int)m.vias.size(), "cidadeInserir devolveu %d", id);
+            m.vias.emplace_back();
+            m.hosp.push_back(h);
+        }
+        int n = qtdCidades;
+        // As últimas rodadas adensam o mapa para formar o núcleo da CH
+        int qtdVias = novas * (rodada < RODADAS / 2 ? 3 : 15);
+        for (int i = 0; i < qtdVias; i++) {
+            int o = 1 + rng() % n, d = 1 + rng() % n, w = sortearTempo();
+            if (o == d && rng() % 4) continue;
+            // Às vezes uma via já existente fica mais curta
+            if (!m.vias[o].empty() && rng() % 5 == 0) {
+                auto it = m.vias[o].begin();
+                advance(it, rng() % m.vias[o].size());
+                d = it->first;
+                w = max(1, it->second / 2);
+            }
+            registroVia(reg, o, d, w);
+            auto it = m.vias[o].find(d);
+            if (it == m.vias[o].end()) m.vias[o][d] = w;
+            else it->second = min(it->second, w);
+        }
+
+        // A tabela nasce na primeira rodada e daí em diante só é mantida
+        // incrementalmente; a CH fica desatualizada até ser reconstruída
+        if (rodada == 0) {
+            modoHospitalDefinir(MODO_CH);
+            tabelaConstruir(tabelaHosp);
+        }
+
+        vector<vector<Custo>> distTempo(n + 1), distTrechos(n + 1);
+        for (int v = 1; v <= n; v++) {
+            distTempo[v] = distanciasReferencia(m, v, false);
+            distTrechos[v] = distanciasReferencia(m, v, true);
+        }
+        auto esperado = [&](const vector<Custo> &dist) {
+            vector<Custo> c = kCustosReferencia(m, dist, 1);
+            return c.empty() ? DIST_INF : c[0];
+        };
+
+        VERIFICAR(!indiceCH.pronto || rodada == 0, "CH deveria estar desatualizada após cadastros");
+        for (int v = 1; v <= n; v++) {
+            Custo e = esperado(distTempo[v]);
+            conferirRota(m, rotaHospital(v), e, v, false, "ch desatualizada");
+            conferirRota(m, rotaDijkstra(grafo, hospital, qtdCidades, v), e, v, false, "dijkstra");
+            conferirRota(m, rotaTabela(tabelaHosp, v), e, v, false, "tabela");
+            conferirRota(m, rotaLargura(grafo, grafoReverso, hospital, qtdCidades, v),
+                         esperado(distTrechos[v]), v, true, "trechos");
+        }
+
+        indiceCH = IndiceCH();
+        chConstruir(indiceCH);
+        nucleoMaximo = max(nucleoMaximo, indiceCH.ordem.size() - indiceCH.inicioNucleo);
+        for (int v = 1; v <= n; v++) {
+            Custo e = esperado(distTempo[v]);
+            conferirRota(m, rotaCH(indiceCH, v), e, v, false, "ch");
+            conferirRota(m, rotaHospital(v), e, v, false, "rotaHospital(ch)");
+        }
+
+        // Origens fixas (as primeiras cidades) repetem a consulta a cada
+        // rodada e passam pelo cache; as demais são sorteadas
+        for (int q = 0; q < 40; q++) {
+            int v = q < 15 ? 1 + q % n : 1 + rng() % n;
+            int k = 1 + rng() % 5;
+            conferirK(m, kHospitais(v, k, false), kCustosReferencia(m, distTempo[v], k), v, false);
+            conferirK(m, kHospitais(v, k, true), kCustosReferencia(m, distTrechos[v], k), v, true);
+        }
+        registroPublicar(reg);
+        for (int q = 0; q < 40; q++) {
+            int v = q < 15 ? 1 + q % n : 1 + rng() % n;
+            int k = 1 + rng() % 5;
+            conferirK(m, registroKHospitais(reg, v, k), kCustosReferencia(m, distTempo[v], k), v, false);
+            conferirK(m, registroKHospitais(reg, v, k, true), kCustosReferencia(m, distTrechos[v], k), v,
+                      true);
+        }
+    }
+    registroEncerrar(reg);
+    VERIFICAR(nucleoMaximo > 0, "nenhuma rodada formou núcleo na CH");
+    return resultadoTeste("teste_rotas", verificados);
+}